@@ -0,0 +1,23 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "runsim.hpp"
+#include "threadpool.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// one simulation of a batch (a replicate, sweep point or fork)
+struct BatchJob {
+    std::string name; // subdirectory of the output directory
+    std::function<SimSummary(const std::string& job_path)> run; // writes into job_path
+};
+
+bool runBatch(const std::string& input_and_output_path, const std::vector<BatchJob>& jobs, int numThreads, std::vector<SimSummary>& summaries, const std::function<void(int, const SimSummary&)>& finished);
+InputParameters jobParameters(const InputParameters& params);
+void writeBatchSummary(const std::string& summary_path, const std::vector<SimSummary>& summaries, bool moments = false);
+SimSummary summaryMean(const std::vector<SimSummary>& summaries);
+SimSummary summarySD(const std::vector<SimSummary>& summaries);
+
+#endif // BATCH_HPP
@@ -0,0 +1,78 @@
+#ifndef CELLSTORE_HPP
+#define CELLSTORE_HPP
+
+#include "cell.hpp"
+#include "checkpoint.hpp"
+#include "distributions.hpp"
+#include "genotype.hpp"
+#include "genotyperegistry.hpp"
+#include "methslab.hpp"
+#include "parameters.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Structure-of-arrays storage for the cells of one deme: one contiguous column
+// per cell property and a row-major matrix of bit-packed methylation arrays.
+// Cells are appended at the end and swap-removed, so every column stays dense.
+class CellStore {
+private:
+    // shared by all cells of the deme
+    int fcpgs = 0; // number of fCpG sites per cell
+    float methRate = 0; // methylation rate
+    float demethRate = 0; // demethylation rate
+    // one entry per cell
+    std::vector<int> identities; // identity of each cell
+    std::vector<int32_t> genotypes; // table index of each cell's genotype (~k: k-th new genotype of the deme)
+    std::vector<int> numMeth; // methylation events since the initial array
+    std::vector<int> numDemeth; // demethylation events since the initial array
+    std::vector<float> birthRates; // birth rate of each cell's genotype
+    std::vector<float> migRates; // migration rate of each cell's genotype
+    MethSlab methRows; // row i holds the methylation array of cell i
+    int growCells = 1; // cells added to every column when the store is full
+    void makeRoom();
+public:
+    // Constructors
+    CellStore() {}
+    CellStore(int fcpgs, float methRate, float demethRate);
+    // Cell handling
+    void reserve(int numCells, int growCells = 1);
+    void push(const Cell& cell, const Genotype& genotype);
+    int duplicate(int i, int identity);
+    void swapRemove(int i);
+    void moveTo(int i, CellStore& target);
+    // Cell events
+    void methylation(int i, RandomNumberGenerator& rng, std::vector<int>* methCounts = nullptr);
+    bool mutation(int i, const GenotypeRegistry& table, std::vector<Genotype>& newGenotypes, int* nextGenotypeID, float gensElapsed, RandomNumberGenerator& rng, int idStride = 1);
+    void remapGenotypes(const std::vector<int>& newIndices);
+    // Methylation counts
+    void addRowTo(int i, std::vector<int>& counts) const;
+    void subtractRowFrom(int i, std::vector<int>& counts) const;
+    // Checkpointing
+    void save(CheckpointWriter& out) const;
+    static CellStore restore(CheckpointReader& in, const GenotypeRegistry& table, const InputParameters& params);
+    // Getters
+    int size() const { return identities.size(); }
+    int getFCpGs() const { return fcpgs; }
+    float getMethRate() const { return methRate; }
+    float getDemethRate() const { return demethRate; }
+    int getIdentity(int i) const { return identities[i]; }
+    int getGenotype(int i) const { return genotypes[i]; }
+    int getNumMeth(int i) const { return numMeth[i]; }
+    int getNumDemeth(int i) const { return numDemeth[i]; }
+    float getBirthRate(int i) const { return birthRates[i]; }
+    float getMigrationRate(int i) const { return migRates[i]; }
+    const std::vector<int>& getIdentities() const { return identities; }
+    const std::vector<int32_t>& getGenotypes() const { return genotypes; }
+    const std::vector<int>& getNumMeths() const { return numMeth; }
+    const std::vector<int>& getNumDemeths() const { return numDemeth; }
+    const std::vector<float>& getBirthRates() const { return birthRates; }
+    const std::vector<float>& getMigrationRates() const { return migRates; }
+    const uint64_t* getRow(int i) const { return methRows.row(i); }
+    int getRowWords() const { return methRows.getRowWords(); }
+    SlabStats getSlabStats() const { return methRows.getStats(); }
+    // Setters
+    void setMethylationRates(float methRate, float demethRate) { this->methRate = methRate; this->demethRate = demethRate; }
+};
+
+#endif // CELLSTORE_HPP
@@ -0,0 +1,89 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include "distributions.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Checkpoint file layout: an 8-byte magic, the format version, then a flat
+// sequence of fixed-width native-endian fields. Arrays carry their length and
+// start on an 8-byte boundary, so the file is memory-mapped on load and the
+// methylation words and rate trees are copied straight out of the mapping.
+const char CHECKPOINT_MAGIC[8] = { 'M', 'D', 'C', 'K', 'P', 'T', 0, 0 };
+const uint32_t CHECKPOINT_VERSION = 11;
+
+class CheckpointWriter {
+private:
+    std::vector<char> buffer;
+public:
+    // Constructor (writes the header)
+    CheckpointWriter();
+    // Fields
+    template<typename T> void write(const T& value) {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+    template<typename T> void writeArray(const T* values, uint64_t n) {
+        write<uint64_t>(n);
+        align();
+        const char* bytes = reinterpret_cast<const char*>(values);
+        buffer.insert(buffer.end(), bytes, bytes + n * sizeof(T));
+    }
+    template<typename T> void writeArray(const std::vector<T>& values) { writeArray(values.data(), values.size()); }
+    void writeString(const std::string& value);
+    void align();
+    // File handling
+    bool saveTo(const std::string& path) const;
+};
+
+class CheckpointReader {
+private:
+    const char* data; // memory-mapped file contents
+    size_t size;
+    size_t pos;
+    void check(size_t bytes);
+public:
+    // Constructor and destructor (maps the file and checks the header)
+    explicit CheckpointReader(const std::string& path);
+    ~CheckpointReader();
+    // Fields
+    template<typename T> T read() {
+        check(sizeof(T));
+        T value;
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+    template<typename T> std::vector<T> readArray() {
+        uint64_t n = read<uint64_t>();
+        align();
+        check(n * sizeof(T));
+        const T* first = reinterpret_cast<const T*>(data + pos);
+        pos += n * sizeof(T);
+        return std::vector<T>(first, first + n);
+    }
+    std::string readString();
+    void align();
+};
+
+// run-loop state saved alongside the tumour
+struct RunState {
+    int64_t iterations = 0;
+    double outputTimer = 0; // double: per-event increments of large tumours are below float resolution
+    float turnoverTime = 0;
+    float nextCheckpoint = 0; // generation at which the next periodic checkpoint is due
+    int64_t demesFileOffset = 0; // size of the demes file when the checkpoint was written
+    float nextBiopsy = 0; // generation at which the next biopsies are due
+    int64_t biopsyFileOffset = 0; // size of the biopsies file when the checkpoint was written
+    RandomNumberGenerator biopsyStream; // random numbers of biopsies, apart from the simulation's
+    int64_t statsFileOffset = 0; // size of the summary statistics file when the checkpoint was written
+};
+
+// stop requests (SIGTERM/SIGINT) are honoured by writing a checkpoint
+void installStopHandler();
+bool stopRequested();
+
+#endif // CHECKPOINT_HPP
@@ -2,65 +2,122 @@
 #define DEME_HPP
 
 #include "cell.hpp"
+#include "cellstore.hpp"
+#include "checkpoint.hpp"
+#include "fenwick.hpp"
+#include "macros.hpp"
 #include "parameters.hpp"
 
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <unordered_map>
+
+// Rate policies, chosen once per run from the parameters. Without selection
+// on drivers (NeutralRates) every cell of a deme has the same birth and
+// migration rates, so cells are chosen uniformly and no per-cell rate tree is
+// kept; SelectiveRates weights cells by their own rates.
+struct SelectiveRates {};
+struct NeutralRates {};
 
 class Deme {
 private:
     // Fixed properties
     int K; // carrying capacity of the deme
     std::string side; // Left or right
-    int identity; // Identity of the deme (index in tumour)
+    int identity; // Identity of the deme (its index in the tumour, fixed at creation)
     float originTime = 0;
     // Variable properties
     int population; // Number of cancer cells in the deme
-    std::vector<Cell> cellList; // List of cells in the deme
-    std::vector<float> avgMethArray; // Average methylation array of the deme
+    CellStore cells; // Cells of the deme
+    FenwickTree cellRates; // birth + migration rate of each cell, indexed as cells
+    bool trackCellRates = true; // maintain cellRates (false under NeutralRates)
+    std::vector<int> methCounts; // Number of cells methylated at each fCpG allele (maintained incrementally)
+    std::unordered_map<int, int> clones; // Number of cells of each driver genotype in the deme
+    std::vector<Genotype> newGenotypes; // genotypes created since the last commit, referred to as ~k
+    std::vector<int> foundedClones; // genotypes that gained a clone since the last drain
+    std::vector<int> extinctClones; // genotypes that lost their clone since the last drain
     int fissions; // fissions since the initial deme
     // rates
     float deathRate; // Death rate of cells in the deme (population dependent)
-    float sumBirthRates; // Sum of birth rates of the cells in the deme
-    float sumMigRates; // Sum of migration rates of the cells in the deme
+    double sumBirthRates; // Sum of birth rates of the cells in the deme (maintained incrementally)
+    double sumMigRates; // Sum of migration rates of the cells in the deme (maintained incrementally)
+    int eventsSinceResum = 0; // updates since the last exact re-summation
+    int rateResums = 0; // number of exact re-summations (debug counter)
+    double maxRateDrift = 0; // largest drift corrected by a re-summation (debug counter)
     const float baseDeathRate; // Base death rate of cells in the deme (from input params)
+    // random number stream of the deme
+    RandomNumberGenerator rng;
 public:
     // Constructor
-    Deme(int K, std::string side, int identity, int population, int fissions, float deathRate, float baseDeathRate, float sumBirthRates, float sumMigrationRates);
+    Deme(int K, std::string side, int identity, int population, int fissions, float deathRate, float baseDeathRate, float sumBirthRates, float sumMigrationRates, const RandomNumberGenerator& rng);
+    // Checkpointing
+    void save(CheckpointWriter& out) const;
+    static Deme restore(CheckpointReader& in, const GenotypeRegistry& genotypes, const InputParameters& params);
     // Initialise first deme
-    void initialise(std::shared_ptr<Genotype> firstGenotype, const InputParameters& params, const DerivedParameters& d_params);
+    void initialise(int firstGenotype, const GenotypeRegistry& genotypes, const InputParameters& params, const DerivedParameters& d_params);
     // Deme property handling
     void increment(int increment);
-    void calculateAverageArray();
     // Deme events
-    Deme demeFission(float originTime, bool firstFission=false);
+    Deme demeFission(int newIdentity, float originTime, const RandomNumberGenerator& newStream, bool firstFission=false);
     void pseudoFission();
     void moveCells(Deme& targetDeme);
     // Cell events
-    int chooseCell();
-    void cellDivision(int parentIndex, int* next_cell_id, int* nextGenotypeID, float gensElapsed, const InputParameters& params);
+    template<typename Rates> int chooseCell();
+    void cellDivision(int parentIndex, int* next_cell_id, int* nextGenotypeID, float gensElapsed, const GenotypeRegistry& genotypes, int idStride = 1);
     void cellDeath(int cellIndex);
     // Rates handling
     void calculateSumsOfRates();
+    void resumRates();
+    void addCell(const Cell& cell, const Genotype& genotype);
+    void registerCell(int cellIndex);
+    void unregisterCell(int cellIndex);
+    void removeCell(int cellIndex);
+    void moveCell(int cellIndex, Deme& targetDeme);
+    void updateCellRate(int cellIndex, float oldBirthRate, float oldMigRate);
+    // Clone handling
+    void addToClone(int genotype);
+    void removeFromClone(int genotype);
+    void rebuildClones();
+    void commitGenotypes(const std::vector<int>& newIndices);
+    void drainCloneChanges(std::vector<int>& founded, std::vector<int>& extinct);
     // Getters
     int getK() const { return K; }
+    // cells held without reallocating: the population overshoots K until a
+    // fission or the raised death rate above K brings it back
+    static int cellCapacity(int K) { return K + max(K / 4, 8); }
+    static int cellGrowStep(int K) { return max(K / 4, 8); }
     std::string getSide() const { return side; }
     int getPopulation() const { return population; }
     int getIdentity() const { return identity; }
     float getDeathRate() const { return deathRate; }
-    float getSumBirthRates() const { return sumBirthRates; }
-    float getSumMigrationRates() const { return sumMigRates; }
-    float getSumOfRates() const { return sumBirthRates + sumMigRates + population * deathRate; }
-    float getCellBirth(int chosenCell) const { return cellList[chosenCell].getBirthRate(); }
-    float getCellMig(int chosenCell) const { return cellList[chosenCell].getMigrationRate(); }
+    double getSumBirthRates() const { return sumBirthRates; }
+    double getSumMigrationRates() const { return sumMigRates; }
+    double getSumOfRates() const { return sumBirthRates + sumMigRates + population * deathRate; }
+    int getRateResums() const { return rateResums; }
+    double getMaxRateDrift() const { return maxRateDrift; }
+    float getCellBirth(int chosenCell) const { return cells.getBirthRate(chosenCell); }
+    float getCellMig(int chosenCell) const { return cells.getMigrationRate(chosenCell); }
+    const CellStore& getCells() const { return cells; }
+    SlabStats getSlabStats() const { return cells.getSlabStats(); }
     float getOriginTime() const { return originTime; }
+    RandomNumberGenerator& getStream() { return rng; }
     int getFissions() const { return fissions; }
-    std::vector<float> getAverageArray() const { return avgMethArray; }
+    int getNumClones() const { return clones.size(); }
+    const std::vector<Genotype>& getNewGenotypes() const { return newGenotypes; }
+    const std::vector<int>& getMethCounts() const { return methCounts; }
+    std::vector<float> getAverageArray() const;
+    int getNumSites() const { return methCounts.size() / 2; }
+    float getAverageSite(int j) const { return population ? static_cast<float>(methCounts[j] + methCounts[j + getNumSites()]) / (2.0 * population) : 0; }
     // Setters
     void setSide(std::string side) { this->side = side; }
     void setDeathRate() { this->deathRate = population > K ? baseDeathRate + 10 : baseDeathRate; }
     void setOriginTime(float originTime) { this->originTime = originTime; }
+    void setStream(const RandomNumberGenerator& stream) { rng = stream; }
+    void setMethylationRates(float methRate, float demethRate) { cells.setMethylationRates(methRate, demethRate); }
 };
 
+template<> int Deme::chooseCell<SelectiveRates>();
+template<> int Deme::chooseCell<NeutralRates>();
+
 #endif // DEME_HPP
@@ -1,22 +1,51 @@
 #ifndef DISTRIBUTIONS_HPP
 #define DISTRIBUTIONS_HPP
 
+#include <cstdint>
 #include <random>
 
+// Random number stream (xoshiro256**). Streams are derived from one seed by
+// splitting: each split hands out the current state and jumps the parent
+// 2^128 draws ahead, so streams never overlap and every deme or replicate can
+// own one independently of how work is scheduled on threads.
+//
+// Block layout. A run (a single run, a replicate, or a fork) owns two
+// consecutive long-jump blocks of 2^192 draws from its stream S:
+//   block 0 (S): the tumour stream, and the deme streams split from it
+//     (J^k S for the k-th split, J = jump)
+//   block 1 (L S, L = longJump): biopsies (Sampler::streamFor)
+// Replicates are split with splitRun, which moves the parent past both
+// blocks, so replicate r starts at L^2r of the seed. Forks start at L^2 of
+// their seed, after the blocks of the growth phase run with that seed.
 class RandomNumberGenerator {
 public:
-    static RandomNumberGenerator& getInstance();
-    void setSeed(unsigned int seed);
+    typedef uint64_t result_type;
+    // Constructor
+    explicit RandomNumberGenerator(uint64_t seed = 0) { setSeed(seed); }
+    void setSeed(uint64_t seed);
+    // Stream handling
+    RandomNumberGenerator split();
+    RandomNumberGenerator splitRun();
+    void jump();
+    void longJump();
+    // Raw draws (UniformRandomBitGenerator interface, e.g. for std::shuffle)
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+    result_type operator()();
+    // Distributions
     double unitUnifDist();
     int poissonDist(double lambda);
+    int binomialDist(int n, double p);
     double expDist(double lambda);
+    int geometricDist(double p);
     int stochasticRound(double a);
     unsigned int hypergeometricDist(unsigned int n1, unsigned int n2, unsigned int t);
-    std::mt19937 getEngine();
+    // State access (for checkpointing)
+    uint64_t getState(int i) const { return state[i]; }
+    void setState(int i, uint64_t value) { state[i] = value; }
 private:
-    RandomNumberGenerator();
-    std::mt19937 rng;
-    std::uniform_real_distribution<double> dist;
+    uint64_t state[4];
+    void jumpBy(const uint64_t* poly);
 };
 
-#endif // DISTRIBUTIONS_HPP
\ No newline at end of file
+#endif // DISTRIBUTIONS_HPP
@@ -0,0 +1,12 @@
+#ifndef ENSEMBLE_HPP
+#define ENSEMBLE_HPP
+
+#include "batch.hpp"
+
+#include <string>
+#include <vector>
+
+void runEnsemble(const std::string& input_and_output_path, const InputParameters& params, int replicates, int numThreads, bool resume = false);
+std::vector<RandomNumberGenerator> replicateStreams(uint64_t seed, int replicates);
+
+#endif // ENSEMBLE_HPP
@@ -0,0 +1,34 @@
+#ifndef FENWICK_HPP
+#define FENWICK_HPP
+
+#include "checkpoint.hpp"
+#include <vector>
+
+// Fenwick (binary indexed) tree over non-negative weights, supporting
+// O(log n) point updates, append/remove-last and weighted sampling
+class FenwickTree {
+private:
+    std::vector<double> values; // weight of each element
+    std::vector<double> tree; // partial sums (1-based)
+    double prefixSum(int n) const;
+public:
+    // Constructor
+    FenwickTree() : tree(1, 0) {}
+    // Element handling
+    void pushBack(double value);
+    void popBack();
+    void set(int i, double value);
+    void clear();
+    void rebuild();
+    // Checkpointing
+    void save(CheckpointWriter& out) const;
+    void load(CheckpointReader& in);
+    // Sampling
+    int find(double r) const;
+    // Getters
+    int size() const { return values.size(); }
+    double get(int i) const { return values[i]; }
+    double total() const { return prefixSum(values.size()); }
+};
+
+#endif // FENWICK_HPP
@@ -0,0 +1,12 @@
+#ifndef FORK_HPP
+#define FORK_HPP
+
+#include "batch.hpp"
+#include "sweep.hpp"
+
+#include <string>
+
+void runForks(const std::string& input_and_output_path, const boost::property_tree::ptree& basePt, const std::string& fork_file_with_path, int numThreads);
+bool isForkParameter(const std::string& key);
+
+#endif // FORK_HPP
@@ -0,0 +1,38 @@
+#ifndef GENOTYPEREGISTRY_HPP
+#define GENOTYPEREGISTRY_HPP
+
+#include "checkpoint.hpp"
+#include "genotype.hpp"
+#include "parameters.hpp"
+
+#include <vector>
+
+// Contiguous table of the driver genotypes of a tumour, referred to by index
+// from cells. A genotype is referenced by each deme holding a clone of it and
+// by each of its child genotypes; once released by all of them its index is
+// freed for reuse, and its parent is released in turn.
+class GenotypeRegistry {
+private:
+    DriverParameters driver; // model parameters shared by all genotypes
+    std::vector<Genotype> table; // genotype at each index
+    std::vector<int> refs; // demes with a clone of, and children of, each genotype
+    std::vector<char> live; // whether each index holds a genotype
+    std::vector<int> freeIndices; // freed indices, reused last-in first-out
+public:
+    // Constructors
+    GenotypeRegistry() {}
+    explicit GenotypeRegistry(const DriverParameters& driver) : driver(driver) {}
+    // Genotype handling
+    int add(const Genotype& genotype);
+    void retain(int index) { refs[index]++; }
+    void release(int index);
+    // Checkpointing
+    void save(CheckpointWriter& out) const;
+    void load(CheckpointReader& in);
+    // Getters
+    const DriverParameters& getDriverParameters() const { return driver; }
+    const Genotype& operator[](int index) const { return table[index]; }
+    int getNumGenotypes() const { return table.size() - freeIndices.size(); }
+};
+
+#endif // GENOTYPEREGISTRY_HPP
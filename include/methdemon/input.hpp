@@ -8,7 +8,17 @@
 #include <iostream>
 #include <string>
 
+// command-line options following the output directory and config file name
+struct RunOptions {
+    int replicates = 1; // --replicates N: run N replicates in one process
+    int threads = 0; // --threads N: worker threads for replicates, sweep points or forks (0: all)
+    std::string sweepFile; // --sweep FILE: sweep spec in the output directory
+    std::string forkFile; // --fork FILE: turnover fork spec in the output directory
+    bool resume = false; // --resume: continue from checkpoint.bin where present
+};
+
 std::string getInputPath(int argc, char* argv[]);
+RunOptions parseRunOptions(int argc, char* argv[]);
 InputParameters readParameters(const boost::property_tree::ptree& pt, const std::string& config_file_path);
 
 #endif // INPUT_HPP
\ No newline at end of file
@@ -4,6 +4,12 @@
 #include <cmath>
 #include <type_traits>
 
+// number of deme events between exact re-summations of the incrementally
+// maintained rate sums (0 disables re-summation)
+#ifndef RATE_RESUM_INTERVAL
+#define RATE_RESUM_INTERVAL 10000
+#endif
+
 template<typename T1, typename T2>
 inline typename std::common_type<T1, T2>::type min(const T1& x, const T2& y) {
     return (x < y) ? x : y;
@@ -0,0 +1,35 @@
+#ifndef METHARRAY_HPP
+#define METHARRAY_HPP
+
+#include <cstdint>
+#include <vector>
+
+// Bit-packed fCpG array: one bit per allele, 64 alleles per word
+class MethArray {
+private:
+    int size; // number of fCpG alleles
+    std::vector<uint64_t> words; // packed methylation states
+public:
+    // Constructors
+    MethArray() : size(0) {}
+    explicit MethArray(int size) : size(size), words(numWordsFor(size), 0) {}
+    MethArray(int size, const std::vector<uint64_t>& words) : size(size), words(words) {}
+    // Bit access
+    int get(int i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+    void set(int i) { words[i >> 6] |= uint64_t(1) << (i & 63); }
+    void reset(int i) { words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+    void flip(int i) { words[i >> 6] ^= uint64_t(1) << (i & 63); }
+    // Word operations
+    int count() const;
+    void addTo(std::vector<int>& counts) const { addWordsTo(words.data(), words.size(), counts); }
+    static void addWordsTo(const uint64_t* words, int numWords, std::vector<int>& counts);
+    static void subtractWordsFrom(const uint64_t* words, int numWords, std::vector<int>& counts);
+    // Getters
+    int getSize() const { return size; }
+    int getNumWords() const { return words.size(); }
+    uint64_t getWord(int k) const { return words[k]; }
+    const std::vector<uint64_t>& getWords() const { return words; }
+    static int numWordsFor(int size) { return (size + 63) / 64; }
+};
+
+#endif // METHARRAY_HPP
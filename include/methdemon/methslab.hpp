@@ -0,0 +1,55 @@
+#ifndef METHSLAB_HPP
+#define METHSLAB_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// allocation counters of methylation slabs
+struct SlabStats {
+    long rowsInUse = 0; // rows holding live cells
+    long rowCapacity = 0; // rows allocated
+    long freshRows = 0; // appends served by rows never used before
+    long reusedRows = 0; // appends served by rows freed by removed cells
+    long copiedRows = 0; // rows copied into the slab (divisions and migrations)
+    long grows = 0; // reallocations of the slab
+    void add(const SlabStats& other);
+};
+
+// Slab of fixed-size methylation rows, row i belonging to cell i of a deme.
+// Removing a cell moves the last row into its slot, so freed rows collect at
+// the tail and act as a free list: appends reuse them without allocating, and
+// the slab only reallocates, by a fixed number of rows, when every row is in use.
+class MethSlab {
+private:
+    int rowWords = 0; // words per row
+    int numRows = 0; // rows in use
+    int usedRows = 0; // rows that have ever been in use
+    int growRows = 1; // rows added when a full slab grows
+    std::vector<uint64_t> words; // capacity * rowWords words
+    long freshRows = 0;
+    long reusedRows = 0;
+    long copiedRows = 0;
+    long grows = 0;
+    int capacity() const { return rowWords ? words.size() / rowWords : 0; }
+    void grow(int rows);
+public:
+    // Constructors
+    MethSlab() {}
+    explicit MethSlab(int rowWords) : rowWords(rowWords) {}
+    // Row handling
+    void reserve(int rows, int growRows = 1);
+    uint64_t* append();
+    int appendCopy(int i);
+    int appendFrom(const MethSlab& source, int i);
+    void swapRemove(int i);
+    void assign(const std::vector<uint64_t>& rowData);
+    // Getters
+    int size() const { return numRows; }
+    int getRowWords() const { return rowWords; }
+    uint64_t* row(int i) { return words.data() + static_cast<size_t>(i) * rowWords; }
+    const uint64_t* row(int i) const { return words.data() + static_cast<size_t>(i) * rowWords; }
+    SlabStats getStats() const;
+};
+
+#endif // METHSLAB_HPP
@@ -1,21 +1,109 @@
 #ifndef OUTPUT_HPP
 #define OUTPUT_HPP
 
+#include "parameters.hpp"
+#include "sampling.hpp"
+#include "spscqueue.hpp"
+#include "statistics.hpp"
 #include "tumour.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
+// Demes file formats. CSV writes one text row per deme per output time. The
+// binary formats write a file header followed by fixed-size records, so the
+// file can be memory-mapped as an array of records:
+//   header (32 bytes): char magic[8] = "MDDEMES\0", uint32 version,
+//     uint32 format (1 or 2), uint32 sites, uint32 recordBytes, 8 bytes zero
+//   record (recordBytes): float32 generation, int32 deme, int32 side
+//     (0: left, 1: right), int32 population, float32 originTime, then the
+//     average methylation of each fCpG site as float32 (DEMES_FLOAT32) or as
+//     uint16 scaled by 65535 (DEMES_UINT16), zero-padded to 8 bytes
+// All fields are native-endian.
+enum DemesFormat { DEMES_CSV = 0, DEMES_FLOAT32 = 1, DEMES_UINT16 = 2 };
+const char DEMES_MAGIC[8] = { 'M', 'D', 'D', 'E', 'M', 'E', 'S', 0 };
+const uint32_t DEMES_VERSION = 1;
+
+// Cells file: a header followed by one chunk per deme, so that only one deme
+// is encoded at a time. Decoded by scripts/read_cells.py.
+//   header (32 bytes): char magic[8] = "MDCELLS\0", uint32 version,
+//     uint32 fcpgs (alleles per cell), uint32 rowWords, uint32 numDemes,
+//     float32 generation, 4 bytes zero
+//   chunk header (32 bytes): uint32 deme, uint32 numCells, uint32 compression
+//     (0: none, 1: zlib), 4 bytes zero, uint64 rawBytes, uint64 storedBytes
+//   chunk payload (storedBytes, zlib stream of rawBytes if compressed):
+//     int32 cellID[n], int32 genotypeID[n], int32 numMeth[n],
+//     int32 numDemeth[n], uint64 words[n * rowWords], where allele j of a
+//     cell is bit j % 64 of its word j / 64, and alleles j and j + fcpgs / 2
+//     belong to fCpG site j
+// All fields are native-endian.
+const char CELLS_MAGIC[8] = { 'M', 'D', 'C', 'E', 'L', 'L', 'S', 0 };
+const uint32_t CELLS_VERSION = 1;
+
+// State of one deme at an output time, copied from the deme so that it can be
+// formatted away from the simulation
+struct DemeSnapshot {
+    std::string side;
+    int population = 0;
+    float originTime = 0;
+    std::vector<int> methCounts; // methylated cells per fCpG allele
+    int getNumSites() const { return methCounts.size() / 2; }
+    float getAverageSite(int j) const { return population ? static_cast<float>(methCounts[j] + methCounts[j + getNumSites()]) / (2.0 * population) : 0; }
+};
+// State of every deme at an output time; deme buffers are reused
+struct DemesSnapshot {
+    float generation = 0;
+    int numDemes = 0;
+    std::vector<DemeSnapshot> demes;
+    void take(Tumour& tumour);
+};
+
+// Output file. Demes files may be written by a background thread: the
+// simulation then only copies a snapshot into a bounded queue, waiting only
+// while the queue is full, and the writer formats and writes it.
 class FileOutput {
 private:
     std::ofstream file;
+    int demesFormat = DEMES_CSV;
+    std::vector<char> buffer; // binary records of one snapshot, written at once
+    DemesSnapshot snapshot; // snapshot used when writing synchronously
+    // background writer
+    std::unique_ptr<SpscQueue<DemesSnapshot> > queue;
+    std::thread writer;
+    std::mutex mutex; // only guards the waits below
+    std::condition_variable published; // a snapshot was queued, or stopping
+    std::condition_variable released; // the writer finished a snapshot
+    std::atomic<bool> stopping;
+    int getRecordBytes(int sites) const;
+    void writeSnapshot(const DemesSnapshot& snapshot);
+    void writerLoop();
+    void drain();
 public:
     // Constructor and destructor
-    FileOutput(const std::string& path) { file.open(path, std::ofstream::out); }
-    ~FileOutput() { file.close(); }
+    FileOutput(const std::string& path, bool append = false, int demesFormat = DEMES_CSV, int queueSize = 0);
+    ~FileOutput();
+    long getPosition() { drain(); file.flush(); return file.tellp(); }
     // Write to file
     void writeDemesFile(Tumour& tumour);
-    void writeCellsFile(Tumour& tumour);
-    void writeDemesHeader();
+    void writeCellsFile(Tumour& tumour, int compression = 0);
+    void writeDemesHeader(Tumour& tumour);
+    void writeBiopsiesHeader();
+    void writeBiopsy(const Biopsy& biopsy);
+    void writeStatsHeader();
+    void writeStats(const SummaryStats& stats);
+    void writeSummaryHeader();
+    void writeSummaryRow(const std::string& label, const SimSummary& summary);
 };
 
+std::string demesFileName(const std::string& stem, int demesFormat);
+bool makeDirectory(const std::string& path);
+bool fileExists(const std::string& path);
+void truncateFile(const std::string& path, long size);
+
 #endif // OUTPUT_HPP
@@ -10,6 +10,7 @@ struct InputParameters {
     int migration_rate_scales_with_K;
     int left_demes;
     int right_demes;
+    int max_demes; // demes tracked when left_demes or right_demes is -1
 
     // fitness
     float normal_birth_rate;
@@ -45,6 +46,26 @@ struct InputParameters {
     // output indicators
     int write_demes_file;
     int write_clones_file;
+    int demes_format; // demes file format (see DemesFormat in output.hpp)
+    int output_queue; // demes snapshots queued for the writer thread (0: write synchronously)
+    int cells_compression; // zlib level of the cells file (0: uncompressed)
+    int write_stats_file; // summary statistics at every output time
+    int stats_bins; // bins of the beta histograms
+    float stats_margin; // sites with beta within this margin of 0 or 1 are not fluctuating
+
+    // virtual biopsies
+    int biopsy_cells; // cells per biopsy (0: no biopsies)
+    float biopsy_interval; // generations between biopsies (0: only at the end of the run)
+    float biopsy_read_depth; // mean sequencing reads per fCpG site
+    int biopsy_pool_demes; // adjacent demes pooled into one biopsy
+    int biopsy_samples; // biopsies per pool of demes
+
+    // checkpointing
+    float checkpoint_interval; // generations between checkpoints (0: only on SIGTERM/SIGINT)
+
+    // parallelism
+    int num_threads; // worker threads (0: all hardware threads)
+    int parallel_demes; // simulate independent demes concurrently
 };
 
 struct DerivedParameters {
@@ -60,6 +81,7 @@ struct DerivedParameters {
     int max_clones;
     int max_demes = 8;
     float fission_modifier;
+    bool neutral_rates = false; // drivers carry no advantage, so all cells share their rates
 };
 
 struct EventCounter {
@@ -71,4 +93,14 @@ struct EventCounter {
     int demethylation=0;
 };
 
+// end-of-run statistics (doubles so that ensemble means and SDs fit too)
+struct SimSummary {
+    double gensElapsed=0;
+    double numDemes=0;
+    double numCells=0;
+    double fissionsPerDeme=0;
+    double iterations=0;
+    double runningTime=0; // seconds
+};
+
 #endif
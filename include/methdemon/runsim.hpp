@@ -1,15 +1,43 @@
 #ifndef RUNSIM_HPP
 #define RUNSIM_HPP
 
+#include "checkpoint.hpp"
 #include "initialise.hpp"
 #include "output.hpp"
+#include "sampling.hpp"
 #include "tumour.hpp"
 
 #include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 
-void runSim(const std::string& input_and_output_path, const std::string& config_file_with_path, const InputParameters& params);
+// everything a simulation phase needs besides the tumour and its RunState
+struct RunContext {
+    const InputParameters& params;
+    const DerivedParameters& d_params;
+    FileOutput& demesFile;
+    ThreadPool* pool; // workers for independent-deme phases (nullptr: serial)
+    Sampler* sampler; // virtual biopsies (nullptr: none)
+    FileOutput* biopsyFile;
+    SummaryStats* stats; // summary statistics (nullptr: none)
+    FileOutput* statsFile;
+    std::string checkpointPath;
+    bool verbose;
+};
+
+SimSummary runSim(const std::string& input_and_output_path, const InputParameters& params, const DerivedParameters& d_params, const RandomNumberGenerator& stream, bool verbose = true, bool resume = false);
+bool runGrowth(Tumour& tumour, RunState& state, RunContext& context);
+bool runTurnover(Tumour& tumour, RunState& state, RunContext& context);
+void writeStats(Tumour& tumour, RunContext& context);
+void takeBiopsies(Tumour& tumour, RunState& state, RunContext& context);
+void biopsyIfDue(Tumour& tumour, RunState& state, RunContext& context);
+bool checkpointIfDue(Tumour& tumour, RunState& state, RunContext& context);
+SimSummary summarise(Tumour& tumour, const RunState& state, double runningTime);
+void printSummary(Tumour& tumour, const SimSummary& summary);
+void writeCheckpoint(const std::string& path, const Tumour& tumour, const RunState& state);
+void readCheckpoint(const std::string& path, Tumour& tumour, RunState& state, const InputParameters& params, const DerivedParameters& d_params);
 float calculateTime(Tumour& tumour);
+void printProgress(Tumour& tumour, long iterations);
 
 #endif // RUNSIM_HPP
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef SAMPLING_HPP
+#define SAMPLING_HPP
+
+#include "distributions.hpp"
+#include "parameters.hpp"
+#include "tumour.hpp"
+
+#include <string>
+#include <vector>
+
+// One virtual biopsy: methylated reads and read depth at each fCpG site
+struct Biopsy {
+    float generation = 0;
+    std::string side;
+    int firstDeme = 0; // first deme of the pooled window
+    int numDemes = 0; // demes in the pooled window
+    int sample = 0; // biopsy number within the window
+    int cells = 0; // cells drawn
+    std::vector<int> methReads;
+    std::vector<int> depth;
+};
+
+// Virtual biopsies. The demes of each side are grouped, in index order, into
+// windows of `poolDemes` adjacent demes, and each biopsy draws `cells` cells
+// from a window without replacement. Cells are never copied: the number of
+// cells drawn from each deme, and the number of methylated alleles among them
+// at each locus, are hypergeometric draws over the deme's population and
+// per-allele counts (so loci are sampled independently of each other). Each
+// site is then read at Poisson(`readDepth`) depth, with binomial noise on the
+// methylated fraction.
+class Sampler {
+private:
+    int cells; // cells per biopsy
+    float readDepth; // mean reads per fCpG site
+    int poolDemes; // adjacent demes of one side pooled per biopsy
+    int samples; // biopsies per window
+    std::vector<int> methAlleles; // methylated alleles drawn per locus
+    std::vector<int> window; // demes of the current window
+    void biopsy(Tumour& tumour, RandomNumberGenerator& rng, Biopsy& res);
+public:
+    // Constructor
+    explicit Sampler(const InputParameters& params);
+    // Biopsies of every window at the current time
+    std::vector<Biopsy> takeBiopsies(Tumour& tumour, RandomNumberGenerator& rng);
+    // Stream of biopsy random numbers: block 1 of the run (see distributions.hpp)
+    static RandomNumberGenerator streamFor(const RandomNumberGenerator& runStream);
+};
+
+#endif // SAMPLING_HPP
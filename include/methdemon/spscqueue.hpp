@@ -0,0 +1,40 @@
+#ifndef SPSCQUEUE_HPP
+#define SPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single-producer single-consumer ring of reusable slots. The producer
+// fills the slot returned by back() and publishes it with push(); the consumer
+// reads the slot returned by front() and releases it with pop(). Neither side
+// takes a lock, and slots keep their buffers between uses.
+template<typename T>
+class SpscQueue {
+private:
+    std::vector<T> slots;
+    std::atomic<size_t> head; // slots released by the consumer
+    std::atomic<size_t> tail; // slots published by the producer
+public:
+    // Constructor
+    explicit SpscQueue(size_t capacity) : slots(capacity), head(0), tail(0) {}
+    // Producer side: free slot to fill, or nullptr if the queue is full
+    T* back() {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) return nullptr;
+        return &slots[t % slots.size()];
+    }
+    void push() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+    // Consumer side: oldest published slot, or nullptr if the queue is empty
+    T* front() {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return nullptr;
+        return &slots[h % slots.size()];
+    }
+    void pop() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+    // Getters
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+    bool full() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire) == slots.size(); }
+};
+
+#endif // SPSCQUEUE_HPP
@@ -0,0 +1,65 @@
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include "parameters.hpp"
+#include "tumour.hpp"
+
+#include <string>
+#include <vector>
+
+// Running mean and variance (Welford); accumulators of disjoint samples can be
+// merged (Chan et al.)
+struct Welford {
+    long n = 0;
+    double mean = 0;
+    double m2 = 0; // sum of squared deviations from the mean
+    void add(double x);
+    void merge(const Welford& other);
+    double variance() const { return n > 1 ? m2 / (n - 1) : 0; }
+};
+
+// Counts of values in [0, 1] in equal-width bins; 1 falls into the last bin
+struct Histogram {
+    std::vector<long> counts;
+    void reset(int bins) { counts.assign(bins, 0); }
+    void add(double x);
+};
+
+// Summary of the methylation of one deme, or of the whole tumour
+struct MethStats {
+    std::string label; // deme index, or "all" for the whole tumour
+    std::string side;
+    int population = 0;
+    Welford numMeth; // methylation events per cell
+    Welford numDemeth; // demethylation events per cell
+    Welford beta; // average methylation per fCpG site
+    Histogram betaHist; // distribution of beta over fCpG sites
+    float fluctuating = 0; // fraction of fCpG sites with margin < beta < 1 - margin
+    // deme: correlation of its site betas with those of the whole tumour;
+    // tumour: mean correlation over all pairs of demes
+    float correlation = 0;
+};
+
+// Summary statistics of the fCpG beta values at an output time, computed in
+// one pass over the per-allele methylation counts that demes keep up to date
+// and over the per-cell event counters, so that neither the methylation
+// arrays nor the per-site averages have to be written out. Buffers are reused
+// between output times.
+class SummaryStats {
+private:
+    int bins; // histogram bins over [0, 1]
+    float margin; // sites with beta within margin of 0 or 1 are not fluctuating
+    std::vector<double> siteBeta; // beta per site of the current deme
+    std::vector<long> tumourCounts; // methylated cells per allele over all demes
+    std::vector<double> sumStandardised; // sum over demes of standardised site betas
+    void collect(const std::vector<double>& betas, MethStats& res) const;
+public:
+    float generation = 0;
+    std::vector<MethStats> demes;
+    MethStats tumour;
+    // Constructor
+    explicit SummaryStats(const InputParameters& params);
+    void take(Tumour& tumour);
+};
+
+#endif // STATISTICS_HPP
@@ -0,0 +1,27 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include "batch.hpp"
+#include "input.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// one point of a parameter sweep
+struct SweepPoint {
+    int index; // position in the expanded grid
+    std::vector<std::pair<std::string, std::string> > values; // config path -> value
+    InputParameters params;
+    double cost; // relative cost estimate used to start expensive points first
+};
+
+void runSweep(const std::string& input_and_output_path, const boost::property_tree::ptree& basePt, const std::string& sweep_file_with_path, int numThreads, bool resume = false);
+std::vector<SweepPoint> expandSweep(const boost::property_tree::ptree& basePt, const boost::property_tree::ptree& sweepPt, const std::string& config_file_path);
+std::map<int, std::string> readSweepManifest(const std::string& manifest_path);
+std::set<int> readUnchangedPoints(const std::string& points_path, const std::vector<SweepPoint>& points);
+double estimateCost(const InputParameters& params, const DerivedParameters& d_params);
+
+#endif // SWEEP_HPP
@@ -0,0 +1,44 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads with per-worker task queues. Workers take
+// tasks from the front of their own queue and steal from the back of the
+// others' when idle, so uneven tasks are balanced across threads.
+class ThreadPool {
+private:
+    struct TaskQueue {
+        std::deque<std::function<void()> > tasks;
+        std::mutex mutex;
+    };
+    std::vector<std::unique_ptr<TaskQueue> > queues; // one queue per worker
+    std::vector<std::thread> workers;
+    std::mutex mutex; // guards the counters and stopping flag
+    std::condition_variable taskAvailable;
+    std::condition_variable allDone;
+    int pending = 0; // submitted tasks not yet finished
+    int queued = 0; // submitted tasks not yet taken by a worker
+    bool stopping = false;
+    int nextQueue = 0; // round-robin submission target
+    bool takeTask(int self, std::function<void()>& task);
+    void workerLoop(int self);
+public:
+    // Constructor and destructor
+    explicit ThreadPool(int numThreads);
+    ~ThreadPool();
+    // Task handling
+    void submit(std::function<void()> task);
+    void wait();
+    // Getters
+    int getNumThreads() const { return workers.size(); }
+    static int resolveNumThreads(int requested);
+};
+
+#endif // THREADPOOL_HPP
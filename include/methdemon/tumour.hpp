@@ -3,51 +3,88 @@
 
 #include "parameters.hpp"
 #include "deme.hpp"
+#include "fenwick.hpp"
 #include "genotype.hpp"
+#include "genotyperegistry.hpp"
+#include "threadpool.hpp"
 #include <vector>
 
+enum class EventType { Birth, Death, Fission };
+
 class Tumour {
 private:
     // cell containers
     std::vector<Deme> demes;
-    std::vector<std::shared_ptr<Genotype> > genotypes;
+    GenotypeRegistry genotypes; // live driver genotypes, referred to by index from cells
+    std::vector<int> foundedClones; // clone changes collected from demes, applied
+    std::vector<int> extinctClones; // to the genotype references together
+    // aggregates over demes, refreshed by updateDeme() when a deme changes
+    FenwickTree demeRates; // sum of rates of each deme
+    std::vector<int> demePopulations; // population of each deme at its last refresh
+    std::vector<int> demeFissions; // fissions of each deme at its last refresh
+    int numCells = 0; // total population
+    int numFissions = 0; // total fissions
+    int eventsSinceRebuild = 0; // deme updates since demeRates was last rebuilt
+    // random number stream for deme choice and time; deme streams are split from it
+    RandomNumberGenerator rng;
     // cell and genotype ID tracking
     int nextGenotypeID = 1;
     int nextCellID = 1;
     int leftDemes = 1;
     int rightDemes = 0;
     // temporal variables
-    float gensElapsed = 0;
+    double gensElapsed = 0; // double: per-event increments of large tumours are below float resolution
     float outputTimer = 0;
     int maxGens = 0;
     // misc
     int fissionConfig = 0;
     bool turnoverIndicator = false;
 public:
+    // cached aggregates
+    void updateDeme(int index);
+    void updateAllDemes();
+    void collectGenotypeChanges(Deme& deme);
+    void applyGenotypeChanges();
     // Constructor
-    Tumour(const InputParameters& params, const DerivedParameters& d_params);
+    Tumour(const InputParameters& params, const DerivedParameters& d_params, const RandomNumberGenerator& stream);
     // choose deme, cell and event type
     int chooseDeme();
-    int chooseCell(int chosenDeme) { return demes[chosenDeme].chooseCell(); };
-    std::string chooseEventType(int chosenDeme, int chosenCell);
+    template<typename Rates> EventType chooseEventType(int chosenDeme, int chosenCell, RandomNumberGenerator& stream);
     //perform event
-    void event(const InputParameters& params, const DerivedParameters& d_params);
+    template<typename Rates> void event(const InputParameters& params, const DerivedParameters& d_params);
+    // simulate independent demes, each on its own clock
+    template<typename Rates> long advanceDeme(int index, double& clock, double horizon, int* demeCellID, int* demeGenotypeID, int idStride, const InputParameters& params);
+    template<typename Rates> long advanceDemes(float horizon, ThreadPool& pool, const InputParameters& params);
+    // checkpointing
+    void save(CheckpointWriter& out) const;
+    void load(CheckpointReader& in, const InputParameters& params, const DerivedParameters& d_params);
     // sum all rates (for time tracking)
     float sumAllRates();
     // Getters
     int getNextCellID() const { return nextCellID; }
     int getNextGenotypeID() const { return nextGenotypeID; }
-    int getNumCells() const;
-    float getFissionsPerDeme();
+    int getNumCells() const { return numCells; }
+    float getFissionsPerDeme() const { return static_cast<float>(numFissions) / demes.size(); }
+    double getMaxRateDrift() const;
+    int getRateResums() const;
+    SlabStats getSlabStats() const;
     int getNumDemes() const { return demes.size(); }
-    int getNumGenotypes() const { return genotypes.size(); }
+    int getNumGenotypes() const { return genotypes.getNumGenotypes(); }
+    int getNumClones() const;
     float getGensElapsed() const { return gensElapsed; }
     float getOutputTimer() const { return outputTimer; }
     bool getTurnoverIndicator() const { return turnoverIndicator; }
     Deme& getDeme(int index) { return demes[index]; }
+    const GenotypeRegistry& getGenotypes() const { return genotypes; }
+    RandomNumberGenerator& getStream() { return rng; }
     // Setters
     void setGensElapsed(float gensAdded = 0) { gensElapsed += gensAdded; }
     void setTurnoverIndicator(bool indi = true) { turnoverIndicator = indi; }
+    void reseed(const RandomNumberGenerator& stream);
+    void setMethylationRates(float methRate, float demethRate);
 };
 
+template<> EventType Tumour::chooseEventType<SelectiveRates>(int chosenDeme, int chosenCell, RandomNumberGenerator& stream);
+template<> EventType Tumour::chooseEventType<NeutralRates>(int chosenDeme, int chosenCell, RandomNumberGenerator& stream);
+
 #endif // TUMOUR_HPP
@@ -0,0 +1,23 @@
+#!/bin/sh
+# Events per second of the growth and turnover phases as the number of
+# tracked demes grows. Run from the repository root after `make all`:
+#   scripts/bench_demes.sh [max_fissions] [deme counts...]
+
+fissions=${1:-4}
+[ $# -gt 0 ] && shift
+demes=${*:-"8 64 512 4096"}
+dir=$(mktemp -d)
+
+echo "Demes,Cells,Events,Seconds,EventsPerSecond,PeakMB"
+for d in $demes; do
+    mkdir -p "$dir/$d"
+    sed -e "s/^\( *max_fissions\).*/\1 $fissions/" \
+        -e "s/^\( *right_demes\).*/&\n    max_demes $d/" \
+        resources/config.dat > "$dir/$d/config.dat"
+    bin/methdemon "$dir/$d/" config.dat | awk -v d="$d" '
+        / cells; / { cells = $3 }
+        /^Running time:/ { secs = $3; rate = $5 }
+        /^Peak memory:/ { peak = $3 }
+        END { events = int(secs * rate + 0.5); print d "," cells "," events "," secs "," rate "," peak }'
+done
+rm -rf "$dir"
@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+"""Decode a cells file (final_cells.bin) written by methdemon.
+
+As a script, prints one CSV row per cell:
+    scripts/read_cells.py <output_dir>/final_cells.bin > cells.csv
+As a module, read_cells(path) yields one dict of NumPy arrays per deme.
+"""
+import struct
+import sys
+import zlib
+
+import numpy as np
+
+MAGIC = b"MDCELLS\0"
+
+
+def read_cells(path):
+    with open(path, "rb") as f:
+        if f.read(8) != MAGIC:
+            raise ValueError(path + " is not a cells file")
+        version, fcpgs, row_words, num_demes, generation = struct.unpack("=4If4x", f.read(24))
+        for _ in range(num_demes):
+            deme, n, compressed, raw_bytes, stored_bytes = struct.unpack("=3I4xQQ", f.read(32))
+            payload = f.read(stored_bytes)
+            if compressed:
+                payload = zlib.decompress(payload)
+            columns = np.frombuffer(payload, np.int32, 4 * n).reshape(4, n)
+            words = np.frombuffer(payload, np.uint64, n * row_words, 16 * n).reshape(n, row_words)
+            # allele j is bit j % 64 of word j / 64
+            alleles = np.unpackbits(words.view(np.uint8), axis=1, bitorder="little")[:, :fcpgs]
+            yield {"generation": generation, "deme": deme, "cell": columns[0],
+                   "genotype": columns[1], "num_meth": columns[2],
+                   "num_demeth": columns[3], "alleles": alleles}
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("usage: read_cells.py <cells_file>")
+    out = sys.stdout
+    out.write("Generation,Deme,Cell,Genotype,NumMeth,NumDemeth,Array\n")
+    for chunk in read_cells(sys.argv[1]):
+        for k in range(len(chunk["cell"])):
+            out.write("%g,%d,%d,%d,%d,%d,%s\n" % (
+                chunk["generation"], chunk["deme"], chunk["cell"][k],
+                chunk["genotype"][k], chunk["num_meth"][k],
+                chunk["num_demeth"][k], "".join(map(str, chunk["alleles"][k]))))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,88 @@
+#include "batch.hpp"
+
+#include <cmath>
+#include <mutex>
+
+// run the jobs concurrently on `numThreads` threads, each in its own
+// subdirectory; `finished` is called under a lock for every job that completes
+// without a stop request. Returns false if a stop was requested.
+bool runBatch(const std::string& input_and_output_path, const std::vector<BatchJob>& jobs,
+    int numThreads, std::vector<SimSummary>& summaries,
+    const std::function<void(int, const SimSummary&)>& finished) {
+    summaries.assign(jobs.size(), SimSummary());
+    std::mutex printMutex;
+    ThreadPool pool(numThreads);
+    for (int j = 0; j < static_cast<int>(jobs.size()); j++) {
+        pool.submit([&, j] {
+            std::string jobPath = input_and_output_path + jobs[j].name + "/";
+            if (!makeDirectory(jobPath)) {
+                std::lock_guard<std::mutex> lock(printMutex);
+                std::cerr << "ERROR: Cannot create directory " << jobPath << std::endl;
+                exit(1);
+            }
+            summaries[j] = jobs[j].run(jobPath);
+            std::lock_guard<std::mutex> lock(printMutex);
+            if (stopRequested()) return;
+            finished(j, summaries[j]);
+        });
+    }
+    pool.wait();
+    return !stopRequested();
+}
+
+// parameters of one job: jobs occupy the workers, so demes within a job run serially
+InputParameters jobParameters(const InputParameters& params) {
+    InputParameters jobParams = params;
+    jobParams.num_threads = 1;
+    return jobParams;
+}
+
+// one row per job, labelled by its position, optionally followed by their mean and sd
+void writeBatchSummary(const std::string& summary_path, const std::vector<SimSummary>& summaries, bool moments) {
+    FileOutput summaryFile(summary_path);
+    summaryFile.writeSummaryHeader();
+    for (int j = 0; j < static_cast<int>(summaries.size()); j++) {
+        summaryFile.writeSummaryRow(std::to_string(j), summaries[j]);
+    }
+    if (moments) {
+        summaryFile.writeSummaryRow("mean", summaryMean(summaries));
+        summaryFile.writeSummaryRow("sd", summarySD(summaries));
+    }
+}
+
+// field-wise mean of run summaries
+SimSummary summaryMean(const std::vector<SimSummary>& summaries) {
+    SimSummary res;
+    int n = summaries.size();
+    for (int i = 0; i < n; i++) {
+        res.gensElapsed += summaries[i].gensElapsed / n;
+        res.numDemes += summaries[i].numDemes / n;
+        res.numCells += summaries[i].numCells / n;
+        res.fissionsPerDeme += summaries[i].fissionsPerDeme / n;
+        res.iterations += summaries[i].iterations / n;
+        res.runningTime += summaries[i].runningTime / n;
+    }
+    return res;
+}
+// field-wise sample standard deviation of run summaries
+SimSummary summarySD(const std::vector<SimSummary>& summaries) {
+    SimSummary res;
+    int n = summaries.size();
+    if (n < 2) return res;
+    SimSummary mean = summaryMean(summaries);
+    for (int i = 0; i < n; i++) {
+        res.gensElapsed += std::pow(summaries[i].gensElapsed - mean.gensElapsed, 2) / (n - 1);
+        res.numDemes += std::pow(summaries[i].numDemes - mean.numDemes, 2) / (n - 1);
+        res.numCells += std::pow(summaries[i].numCells - mean.numCells, 2) / (n - 1);
+        res.fissionsPerDeme += std::pow(summaries[i].fissionsPerDeme - mean.fissionsPerDeme, 2) / (n - 1);
+        res.iterations += std::pow(summaries[i].iterations - mean.iterations, 2) / (n - 1);
+        res.runningTime += std::pow(summaries[i].runningTime - mean.runningTime, 2) / (n - 1);
+    }
+    res.gensElapsed = std::sqrt(res.gensElapsed);
+    res.numDemes = std::sqrt(res.numDemes);
+    res.numCells = std::sqrt(res.numCells);
+    res.fissionsPerDeme = std::sqrt(res.fissionsPerDeme);
+    res.iterations = std::sqrt(res.iterations);
+    res.runningTime = std::sqrt(res.runningTime);
+    return res;
+}
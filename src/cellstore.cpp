@@ -0,0 +1,182 @@
+#include "cellstore.hpp"
+
+/////// Constructor
+CellStore::CellStore(int fcpgs, float methRate, float demethRate)
+    : fcpgs(fcpgs), methRate(methRate), demethRate(demethRate), methRows(MethArray::numWordsFor(fcpgs)) {}
+
+/////// Cell handling
+// reserve space in every column; a full store then grows by `growCells`
+// cells at a time rather than doubling
+void CellStore::reserve(int numCells, int growCells) {
+    this->growCells = max(growCells, 1);
+    identities.reserve(numCells);
+    genotypes.reserve(numCells);
+    numMeth.reserve(numCells);
+    numDemeth.reserve(numCells);
+    birthRates.reserve(numCells);
+    migRates.reserve(numCells);
+    methRows.reserve(numCells, this->growCells);
+}
+// grow every column before appending to a full store
+void CellStore::makeRoom() {
+    if (size() == static_cast<int>(identities.capacity())) reserve(size() + growCells, growCells);
+}
+// append a cell of the given genotype
+void CellStore::push(const Cell& cell, const Genotype& genotype) {
+    makeRoom();
+    identities.push_back(cell.getIdentity());
+    genotypes.push_back(cell.getGenotype());
+    numMeth.push_back(cell.getNumMeth());
+    numDemeth.push_back(cell.getNumDemeth());
+    birthRates.push_back(genotype.getBirthRate());
+    migRates.push_back(genotype.getMigrationRate());
+    const std::vector<uint64_t>& words = cell.getMethArray().getWords();
+    std::copy(words.begin(), words.end(), methRows.append());
+}
+// append a copy of cell i with a new identity; returns the index of the copy
+int CellStore::duplicate(int i, int identity) {
+    makeRoom();
+    identities.push_back(identity);
+    genotypes.push_back(genotypes[i]);
+    numMeth.push_back(numMeth[i]);
+    numDemeth.push_back(numDemeth[i]);
+    birthRates.push_back(birthRates[i]);
+    migRates.push_back(migRates[i]);
+    methRows.appendCopy(i);
+    return size() - 1;
+}
+// remove cell i by moving the last cell into its place
+void CellStore::swapRemove(int i) {
+    int last = size() - 1;
+    if (i != last) {
+        identities[i] = identities[last];
+        genotypes[i] = genotypes[last];
+        numMeth[i] = numMeth[last];
+        numDemeth[i] = numDemeth[last];
+        birthRates[i] = birthRates[last];
+        migRates[i] = migRates[last];
+    }
+    methRows.swapRemove(i);
+    identities.pop_back();
+    genotypes.pop_back();
+    numMeth.pop_back();
+    numDemeth.pop_back();
+    birthRates.pop_back();
+    migRates.pop_back();
+}
+// move cell i to the end of another store of the same deme geometry; its row
+// is copied once into the target slab
+void CellStore::moveTo(int i, CellStore& target) {
+    target.makeRoom();
+    target.identities.push_back(identities[i]);
+    target.genotypes.push_back(genotypes[i]);
+    target.numMeth.push_back(numMeth[i]);
+    target.numDemeth.push_back(numDemeth[i]);
+    target.birthRates.push_back(birthRates[i]);
+    target.migRates.push_back(migRates[i]);
+    target.methRows.appendFrom(methRows, i);
+    swapRemove(i);
+}
+
+/////// Cell events
+// methylation event
+// Candidate alleles are visited by geometric gap sampling at the larger of the
+// two rates, then thinned by the rate that applies to their current state, so
+// the cost is proportional to the number of flips rather than to fcpgs.
+// Flips are also applied to the per-allele counts of the deme, if given.
+void CellStore::methylation(int i, RandomNumberGenerator& rng, std::vector<int>* methCounts) {
+    float maxRate = max(methRate, demethRate);
+    if (maxRate <= 0) return;
+    uint64_t* row = methRows.row(i);
+    for (int j = rng.geometricDist(maxRate); j < fcpgs; j += 1 + rng.geometricDist(maxRate)) {
+        double rnd = rng.unitUnifDist() * maxRate;
+        uint64_t bit = uint64_t(1) << (j & 63);
+        if ((row[j >> 6] & bit) == 0) {
+            if (rnd < methRate) {
+                row[j >> 6] |= bit;
+                numMeth[i]++;
+                if (methCounts) (*methCounts)[j]++;
+            }
+        } else if (rnd < demethRate) {
+            row[j >> 6] &= ~bit;
+            numDemeth[i]++;
+            if (methCounts) (*methCounts)[j]--;
+        }
+    }
+}
+// mutation event; a new genotype is appended to the deme's new genotypes,
+// which the tumour later moves into its table. Returns whether cell i moved
+// to a new genotype
+bool CellStore::mutation(int i, const GenotypeRegistry &table,
+                         std::vector<Genotype> &newGenotypes,
+                         int *nextGenotypeID, float gensElapsed,
+                         RandomNumberGenerator &rng, int idStride) {
+  const DriverParameters &driver = table.getDriverParameters();
+  int newBirthMut = rng.poissonDist(driver.muDriverBirth);
+  int newMigMut = rng.poissonDist(driver.muDriverMig);
+
+  if (newBirthMut || newMigMut) {
+    int index = genotypes[i];
+    const Genotype &genotype = index >= 0 ? table[index] : newGenotypes[~index];
+    int newIdentity = *nextGenotypeID;
+    *nextGenotypeID += idStride;
+    Genotype newGenotype(genotype.getIdentity(), newIdentity,
+                         genotype.getNumBirthMut() + newBirthMut,
+                         genotype.getNumMigMut() + newMigMut, 0, 0,
+                         gensElapsed);
+    newGenotype.setBirthRate(driver, rng);
+    newGenotype.setMigrationRate(driver, rng);
+    newGenotype.setParentIndex(index);
+    birthRates[i] = newGenotype.getBirthRate();
+    migRates[i] = newGenotype.getMigrationRate();
+    genotypes[i] = ~static_cast<int>(newGenotypes.size());
+    newGenotypes.push_back(newGenotype);
+    return true;
+  }
+  return false;
+}
+// replace references to new genotypes (~k) by their table indices
+void CellStore::remapGenotypes(const std::vector<int> &newIndices) {
+  for (int i = 0; i < size(); i++) {
+    if (genotypes[i] < 0) genotypes[i] = newIndices[~genotypes[i]];
+  }
+}
+
+/////// Methylation counts
+// add the methylated alleles of cell i to per-allele counts
+void CellStore::addRowTo(int i, std::vector<int>& counts) const {
+    MethArray::addWordsTo(getRow(i), methRows.getRowWords(), counts);
+}
+// remove the methylated alleles of cell i from per-allele counts
+void CellStore::subtractRowFrom(int i, std::vector<int>& counts) const {
+    MethArray::subtractWordsFrom(getRow(i), methRows.getRowWords(), counts);
+}
+
+/////// Checkpointing
+// write the columns; genotypes are written as table indices
+void CellStore::save(CheckpointWriter& out) const {
+    out.write<int32_t>(fcpgs);
+    out.writeArray(identities);
+    out.writeArray(genotypes);
+    out.writeArray(numMeth);
+    out.writeArray(numDemeth);
+    out.writeArray(methRows.row(0), static_cast<uint64_t>(size()) * methRows.getRowWords());
+}
+// rebuild a store written by save(); rates are taken from the genotypes and
+// methylation rates from the parameters
+CellStore CellStore::restore(CheckpointReader& in, const GenotypeRegistry& table, const InputParameters& params) {
+    CellStore store(in.read<int32_t>(), params.meth_rate, params.demeth_rate);
+    store.identities = in.readArray<int>();
+    store.genotypes = in.readArray<int32_t>();
+    store.numMeth = in.readArray<int>();
+    store.numDemeth = in.readArray<int>();
+    store.methRows.assign(in.readArray<uint64_t>());
+    store.birthRates.reserve(store.genotypes.size());
+    store.migRates.reserve(store.genotypes.size());
+    for (int i = 0; i < static_cast<int>(store.genotypes.size()); i++) {
+        const Genotype& genotype = table[store.genotypes[i]];
+        store.birthRates.push_back(genotype.getBirthRate());
+        store.migRates.push_back(genotype.getMigrationRate());
+    }
+    return store;
+}
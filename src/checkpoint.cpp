@@ -0,0 +1,103 @@
+#include "checkpoint.hpp"
+
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/////// Writer
+CheckpointWriter::CheckpointWriter() {
+    buffer.insert(buffer.end(), CHECKPOINT_MAGIC, CHECKPOINT_MAGIC + sizeof(CHECKPOINT_MAGIC));
+    write<uint32_t>(CHECKPOINT_VERSION);
+}
+// length-prefixed string
+void CheckpointWriter::writeString(const std::string& value) {
+    write<uint64_t>(value.size());
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+// pad to the next 8-byte boundary
+void CheckpointWriter::align() {
+    while (buffer.size() % 8) buffer.push_back(0);
+}
+// write to a temporary file and rename it, so a crash mid-write never
+// leaves a truncated checkpoint behind
+bool CheckpointWriter::saveTo(const std::string& path) const {
+    std::string tmpPath = path + ".tmp";
+    FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    ok = std::fflush(file) == 0 && ok;
+    ok = fsync(fileno(file)) == 0 && ok;
+    ok = std::fclose(file) == 0 && ok;
+    return ok && std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+/////// Reader
+CheckpointReader::CheckpointReader(const std::string& path) : data(nullptr), size(0), pos(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        std::cout << "ERROR: Cannot open checkpoint " << path << std::endl;
+        exit(1);
+    }
+    size = info.st_size;
+    void* mapping = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cout << "ERROR: Cannot map checkpoint " << path << std::endl;
+        exit(1);
+    }
+    data = static_cast<const char*>(mapping);
+    check(sizeof(CHECKPOINT_MAGIC));
+    if (std::memcmp(data, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+        std::cout << "ERROR: " << path << " is not a methdemon checkpoint." << std::endl;
+        exit(1);
+    }
+    pos = sizeof(CHECKPOINT_MAGIC);
+    uint32_t version = read<uint32_t>();
+    if (version != CHECKPOINT_VERSION) {
+        std::cout << "ERROR: Checkpoint format version " << version
+                  << " is not supported (expected " << CHECKPOINT_VERSION << ")." << std::endl;
+        exit(1);
+    }
+}
+CheckpointReader::~CheckpointReader() {
+    munmap(const_cast<char*>(data), size);
+}
+// length-prefixed string
+std::string CheckpointReader::readString() {
+    uint64_t n = read<uint64_t>();
+    check(n);
+    std::string value(data + pos, n);
+    pos += n;
+    return value;
+}
+// skip padding up to the next 8-byte boundary
+void CheckpointReader::align() {
+    pos = (pos + 7) / 8 * 8;
+}
+// guard against reading past the end of a truncated file
+void CheckpointReader::check(size_t bytes) {
+    if (pos + bytes > size) {
+        std::cout << "ERROR: Checkpoint file is truncated." << std::endl;
+        exit(1);
+    }
+}
+
+/////// Stop requests
+static volatile std::sig_atomic_t stopFlag = 0;
+
+static void handleStop(int) {
+    stopFlag = 1;
+}
+// checkpoint and stop on SIGTERM (e.g. preemption) or SIGINT
+void installStopHandler() {
+    std::signal(SIGTERM, handleStop);
+    std::signal(SIGINT, handleStop);
+}
+bool stopRequested() {
+    return stopFlag != 0;
+}
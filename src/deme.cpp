@@ -1,30 +1,86 @@
 #include "deme.hpp"
 
 /////// Constructor
-Deme::Deme(int K, std::string side, int identity, int population, int fissions, float deathRate, float baseDeathRate, float sumBirthRates, float sumMigRates) : K(K), side(side), identity(identity), population(population), fissions(fissions), deathRate(deathRate), sumBirthRates(sumBirthRates), sumMigRates(sumMigRates), baseDeathRate(baseDeathRate) {
-    avgMethArray.clear();
-    cellList.clear();
+Deme::Deme(int K, std::string side, int identity, int population, int fissions, float deathRate, float baseDeathRate, float sumBirthRates, float sumMigRates, const RandomNumberGenerator& rng) : K(K), side(side), identity(identity), population(population), fissions(fissions), deathRate(deathRate), sumBirthRates(sumBirthRates), sumMigRates(sumMigRates), baseDeathRate(baseDeathRate), rng(rng) {
+    methCounts.clear();
+    cellRates.clear();
+}
+
+/////// Checkpointing
+// write the complete deme state; cells refer to genotypes by table index
+void Deme::save(CheckpointWriter& out) const {
+    out.write<int32_t>(K);
+    out.writeString(side);
+    out.write<int32_t>(identity);
+    out.write<float>(originTime);
+    out.write<int32_t>(population);
+    out.write<int32_t>(fissions);
+    out.write<float>(deathRate);
+    out.write<float>(baseDeathRate);
+    out.write<double>(sumBirthRates);
+    out.write<double>(sumMigRates);
+    out.write<int32_t>(eventsSinceResum);
+    out.write<int32_t>(rateResums);
+    out.write<double>(maxRateDrift);
+    out.write<int32_t>(trackCellRates);
+    for (int i = 0; i < 4; i++) out.write<uint64_t>(rng.getState(i));
+    out.writeArray(methCounts);
+    cellRates.save(out);
+    cells.save(out);
+}
+// rebuild a deme written by save()
+Deme Deme::restore(CheckpointReader& in, const GenotypeRegistry& genotypes, const InputParameters& params) {
+    int K = in.read<int32_t>();
+    std::string side = in.readString();
+    int identity = in.read<int32_t>();
+    float originTime = in.read<float>();
+    int population = in.read<int32_t>();
+    int fissions = in.read<int32_t>();
+    float deathRate = in.read<float>();
+    float baseDeathRate = in.read<float>();
+    RandomNumberGenerator stream;
+    Deme deme(K, side, identity, population, fissions, deathRate, baseDeathRate, 0, 0, stream);
+    deme.originTime = originTime;
+    deme.sumBirthRates = in.read<double>();
+    deme.sumMigRates = in.read<double>();
+    deme.eventsSinceResum = in.read<int32_t>();
+    deme.rateResums = in.read<int32_t>();
+    deme.maxRateDrift = in.read<double>();
+    deme.trackCellRates = in.read<int32_t>();
+    for (int i = 0; i < 4; i++) deme.rng.setState(i, in.read<uint64_t>());
+    deme.methCounts = in.readArray<int>();
+    deme.cellRates.load(in);
+    deme.cells = CellStore::restore(in, genotypes, params);
+    deme.cells.reserve(cellCapacity(K), cellGrowStep(K));
+    deme.rebuildClones();
+    return deme;
 }
 
 /////// Initialise first deme
-void Deme::initialise(std::shared_ptr<Genotype> firstGenotype, const InputParameters& params, const DerivedParameters& d_params) {
+void Deme::initialise(int firstGenotype, const GenotypeRegistry& genotypes, const InputParameters& params, const DerivedParameters& d_params) {
+    trackCellRates = !d_params.neutral_rates;
+    cells = CellStore(d_params.fcpgs, params.meth_rate, params.demeth_rate);
+    cells.reserve(cellCapacity(K), cellGrowStep(K));
     // initialise first cell
-    std::vector<int> tmpArray(d_params.fcpgs, 0);
-    Cell firstCell = Cell(0, firstGenotype, identity, 0, 0, d_params.fcpgs, tmpArray, params.meth_rate, params.demeth_rate);
-    firstCell.initialArray(params.manual_array);
-    cellList.push_back(std::move(firstCell));
-    calculateAverageArray();
+    MethArray tmpArray(d_params.fcpgs);
+    Cell firstCell = Cell(0, firstGenotype, 0, 0, tmpArray);
+    firstCell.initialArray(params.manual_array, rng);
+    addCell(firstCell, genotypes[firstGenotype]);
+    calculateSumsOfRates();
 }
 
 /////// Deme property handling
-// increment or decrement population of the deme and update all rates
+// increment or decrement population of the deme and update the death rate
+// (rate sums are kept up to date by addCell/removeCell/updateCellRate)
 void Deme::increment(int increment) {
     population += increment;
     setDeathRate();
-    calculateSumsOfRates();
+    if (RATE_RESUM_INTERVAL > 0 && ++eventsSinceResum >= RATE_RESUM_INTERVAL) {
+        resumRates();
+    }
 
     // check population sum
-    int num_clones_in_deme = cellList.size();
+    int num_clones_in_deme = cells.size();
     if (population != num_clones_in_deme) {
         std::cout << "ERROR: Population does not equal number of clones in deme." << std::endl
         << "deme identity: " << identity
@@ -34,78 +90,66 @@ void Deme::increment(int increment) {
         exit(1);
     }
 }
-// calculate the average methylation array of the deme
-void Deme::calculateAverageArray() {
-    int fcpgs = cellList[0].getFCpGs();
-    avgMethArray = std::vector<float>(fcpgs / 2, 0);
-    for (int i = 0; i < population; i++) {
-        for (int j = 0; j < fcpgs / 2; j++) {
-            avgMethArray[j] += static_cast<float>(cellList[i].getFCpGSite(j) + cellList[i].getFCpGSite(j + fcpgs / 2)) / 2.0;
-        }
-    }
-    for (int i = 0; i < fcpgs / 2; i++) {
-        avgMethArray[i] /= static_cast<float>(population);
+// average methylation array of the deme (fraction of methylated alleles per
+// fCpG site), scaled from the per-allele counts
+std::vector<float> Deme::getAverageArray() const {
+    std::vector<float> avgMethArray(getNumSites());
+    for (int j = 0; j < getNumSites(); j++) {
+        avgMethArray[j] = getAverageSite(j);
     }
+    return avgMethArray;
 }
 
 /////// Deme events
-// deme fission - returns new deme
-Deme Deme::demeFission(float originTime, bool firstFission) {
+// deme fission - returns new deme, whose identity is the index it will take
+Deme Deme::demeFission(int newIdentity, float originTime, const RandomNumberGenerator& newStream, bool firstFission) {
     fissions++;
     // initialise new deme
-    Deme newDeme = Deme(K, side, identity + 1, 0, 0, 0, baseDeathRate, 0, 0);
+    Deme newDeme = Deme(K, side, newIdentity, 0, 0, 0, baseDeathRate, 0, 0, newStream);
+    newDeme.trackCellRates = trackCellRates;
+    newDeme.cells = CellStore(cells.getFCpGs(), cells.getMethRate(), cells.getDemethRate());
+    newDeme.cells.reserve(cellCapacity(K), cellGrowStep(K));
     if (firstFission) newDeme.setSide("right");
     moveCells(newDeme);
     // update origin deme
     setDeathRate();
-    calculateSumsOfRates();
-    calculateAverageArray();
     // update new deme
     newDeme.setDeathRate();
-    newDeme.calculateSumsOfRates();
-    newDeme.calculateAverageArray();
     newDeme.setOriginTime(originTime);
     return newDeme;
 }
 // pseudo fission - kill half the population randomly
 void Deme::pseudoFission() {
     fissions++;
-    int numCellsToKill = RandomNumberGenerator::getInstance().stochasticRound(population / 2.0);
+    int numCellsToKill = rng.stochasticRound(population / 2.0);
     // get set of indices of cells to kill
     std::vector<int> indices;
     for (int i = 0; i < population; i++) {
         indices.push_back(i);
     }
     // shuffle indices
-    std::shuffle(indices.begin(), indices.end(), RandomNumberGenerator::getInstance().getEngine());
+    std::shuffle(indices.begin(), indices.end(), rng);
     // remove the first `numCellsToKill` indices in descending order
     std::sort(indices.begin(), indices.begin() + numCellsToKill, std::greater<int>());
     for (int i = 0; i < numCellsToKill; i++) {
         cellDeath(indices[i]);
     }
     setDeathRate();
-    calculateSumsOfRates();
 }
 // move cells to target deme
 void Deme::moveCells(Deme& targetDeme) {
-    int numCellsToMove = RandomNumberGenerator::getInstance().stochasticRound(population / 2.0);
+    int numCellsToMove = rng.stochasticRound(population / 2.0);
     // get set of indices of cells to move
     std::vector<int> indices;
     for (int i = 0; i < population; i++) {
         indices.push_back(i);
     }
     // shuffle indices
-    std::shuffle(indices.begin(), indices.end(), RandomNumberGenerator::getInstance().getEngine());
+    std::shuffle(indices.begin(), indices.end(), rng);
     // move the first `numCellsToMove` indices in descending order
     std::sort(indices.begin(), indices.begin() + numCellsToMove, std::greater<int>());
     for (int i = 0; i < numCellsToMove; i++) {
-        int index = indices[i];
-        targetDeme.cellList.push_back(std::move(cellList[index]));
-        targetDeme.cellList.back().setDeme(targetDeme.getIdentity());
-        if(index != population - 1) {
-            std::swap(cellList[index], cellList.back());
-        }
-        cellList.pop_back();
+        moveCell(indices[i], targetDeme);
     }
     increment(-numCellsToMove);
     targetDeme.increment(numCellsToMove);
@@ -113,58 +157,163 @@ void Deme::moveCells(Deme& targetDeme) {
 
 /////// Cell events
 // choose cell for event
-int Deme::chooseCell() {
-    std::vector<double> cumRates;
-    double r;
-
-    if (population == 1) {
-        return 0;
-    } else {
-        double rateSum = 0.0;
-        for (int i = 0; i < population; i++) {
-            rateSum += deathRate + cellList[i].getBirthRate() + cellList[i].getMigrationRate();
-            cumRates.push_back(rateSum);
-        }
-        double rnd = RandomNumberGenerator::getInstance().unitUnifDist();
-        r = rnd * cumRates.back();
-    }
-
-    if (population == 2) {
-        return r < cumRates[0] ? 0 : 1;
-    } else {
-        auto it = std::lower_bound(cumRates.begin(), cumRates.end(), r);
-        return std::distance(cumRates.begin(), it);
+// Each cell's weight is deathRate + birth + migration. The death part is the
+// same for every cell, so it is sampled uniformly; the rest comes from the
+// Fenwick tree over per-cell birth + migration rates in O(log K).
+template<> int Deme::chooseCell<SelectiveRates>() {
+    if (population == 1) return 0;
+    double deathSum = static_cast<double>(population) * deathRate;
+    double rnd = rng.unitUnifDist();
+    double r = rnd * (deathSum + cellRates.total());
+    if (r < deathSum) {
+        return min(static_cast<int>(r / deathRate), population - 1);
     }
+    return cellRates.find(r - deathSum);
+}
+// every cell has the same weight, so choose uniformly in O(1)
+template<> int Deme::chooseCell<NeutralRates>() {
+    if (population == 1) return 0;
+    double rnd = rng.unitUnifDist();
+    return min(static_cast<int>(rnd * population), population - 1);
 }
 // cell division
 void Deme::cellDivision(int parentIndex, int *nextCellID, int *nextGenotypeID,
-                        float const gensElapsed, const InputParameters &params) {
-  Cell &parent = cellList[parentIndex];
-  Cell daughter =
-      Cell((*nextCellID)++, parent.getGenotype(), identity, parent.getNumMeth(),
-           parent.getNumDemeth(), parent.getFCpGs(), parent.getMethArray(),
-           parent.getMethRate(), parent.getDemethRate());
-  parent.methylation();
-  daughter.methylation();
-  parent.mutation(nextGenotypeID, gensElapsed, params);
-  daughter.mutation(nextGenotypeID, gensElapsed, params);
-  cellList.push_back(std::move(daughter));
+                        float const gensElapsed,
+                        const GenotypeRegistry &genotypes, int idStride) {
+  float oldBirthRate = cells.getBirthRate(parentIndex);
+  float oldMigRate = cells.getMigrationRate(parentIndex);
+  int daughterID = *nextCellID;
+  *nextCellID += idStride;
+  int daughterIndex = cells.duplicate(parentIndex, daughterID);
+  // the daughter's alleles are counted when it is registered
+  cells.methylation(parentIndex, rng, &methCounts);
+  cells.methylation(daughterIndex, rng);
+  int oldGenotype = cells.getGenotype(parentIndex);
+  if (cells.mutation(parentIndex, genotypes, newGenotypes, nextGenotypeID,
+                     gensElapsed, rng, idStride)) {
+    removeFromClone(oldGenotype);
+    addToClone(cells.getGenotype(parentIndex));
+  }
+  cells.mutation(daughterIndex, genotypes, newGenotypes, nextGenotypeID,
+                 gensElapsed, rng, idStride);
+  updateCellRate(parentIndex, oldBirthRate, oldMigRate);
+  registerCell(daughterIndex);
   increment(1);
 }
 // cell death
 void Deme::cellDeath(int cellIndex) {
-    std::swap(cellList[cellIndex], cellList.back());
-    cellList.pop_back();
+    removeCell(cellIndex);
     increment(-1);
 }
 
 /////// Rates handling
-// calculate all rates
+// calculate all rates exactly
 void Deme::calculateSumsOfRates() {
+    const std::vector<float>& birthRates = cells.getBirthRates();
+    const std::vector<float>& migRates = cells.getMigrationRates();
     sumBirthRates = 0;
     sumMigRates = 0;
     for (int i = 0; i < population; i++) {
-        sumBirthRates += cellList[i].getBirthRate();
-        sumMigRates += cellList[i].getMigrationRate();
+        sumBirthRates += birthRates[i];
+        sumMigRates += migRates[i];
     }
 }
+// re-sum rates exactly to bound floating-point drift and record the drift
+void Deme::resumRates() {
+    double oldSum = sumBirthRates + sumMigRates;
+    calculateSumsOfRates();
+    cellRates.rebuild();
+    maxRateDrift = max(maxRateDrift, std::fabs(sumBirthRates + sumMigRates - oldSum));
+    rateResums++;
+    eventsSinceResum = 0;
+}
+
+/////// Cell list handling
+// append a cell, its rate and its methylated alleles
+void Deme::addCell(const Cell& cell, const Genotype& genotype) {
+    cells.push(cell, genotype);
+    registerCell(cells.size() - 1);
+}
+// add the rate and methylated alleles of the last cell in the store
+void Deme::registerCell(int cellIndex) {
+    if (methCounts.empty()) methCounts.assign(cells.getFCpGs(), 0);
+    cells.addRowTo(cellIndex, methCounts);
+    sumBirthRates += cells.getBirthRate(cellIndex);
+    sumMigRates += cells.getMigrationRate(cellIndex);
+    if (trackCellRates) cellRates.pushBack(cells.getBirthRate(cellIndex) + cells.getMigrationRate(cellIndex));
+    addToClone(cells.getGenotype(cellIndex));
+}
+// remove the rate and methylated alleles of a cell about to be swap-removed
+void Deme::unregisterCell(int cellIndex) {
+    int last = cells.size() - 1;
+    cells.subtractRowFrom(cellIndex, methCounts);
+    sumBirthRates -= cells.getBirthRate(cellIndex);
+    sumMigRates -= cells.getMigrationRate(cellIndex);
+    removeFromClone(cells.getGenotype(cellIndex));
+    if (!trackCellRates) return;
+    if (cellIndex != last) cellRates.set(cellIndex, cellRates.get(last));
+    cellRates.popBack();
+}
+// swap-remove a cell, its rate and its methylated alleles
+void Deme::removeCell(int cellIndex) {
+    unregisterCell(cellIndex);
+    cells.swapRemove(cellIndex);
+}
+// move a cell to the end of the target deme without going through a Cell
+void Deme::moveCell(int cellIndex, Deme& targetDeme) {
+    unregisterCell(cellIndex);
+    cells.moveTo(cellIndex, targetDeme.cells);
+    targetDeme.registerCell(targetDeme.cells.size() - 1);
+}
+// refresh a cell's rate after its genotype changed
+void Deme::updateCellRate(int cellIndex, float oldBirthRate, float oldMigRate) {
+    sumBirthRates += cells.getBirthRate(cellIndex) - oldBirthRate;
+    sumMigRates += cells.getMigrationRate(cellIndex) - oldMigRate;
+    if (trackCellRates) cellRates.set(cellIndex, cells.getBirthRate(cellIndex) + cells.getMigrationRate(cellIndex));
+}
+
+/////// Clone handling
+// count a cell of a genotype; a new clone is reported to the tumour, which
+// holds a reference to the genotype for each deme with a clone of it
+void Deme::addToClone(int genotype) {
+    if (++clones[genotype] == 1) foundedClones.push_back(genotype);
+}
+// uncount a cell of a genotype; a clone that dies out is reported as well
+void Deme::removeFromClone(int genotype) {
+    std::unordered_map<int, int>::iterator clone = clones.find(genotype);
+    if (--clone->second > 0) return;
+    clones.erase(clone);
+    extinctClones.push_back(genotype);
+}
+// recount the clones from the cells
+void Deme::rebuildClones() {
+    clones.clear();
+    for (int i = 0; i < cells.size(); i++) {
+        clones[cells.getGenotype(i)]++;
+    }
+}
+// replace references to new genotypes (~k) by the table indices they were
+// given, in the cells, the clones and the pending clone changes
+void Deme::commitGenotypes(const std::vector<int>& newIndices) {
+    cells.remapGenotypes(newIndices);
+    for (int k = 0; k < static_cast<int>(newIndices.size()); k++) {
+        std::unordered_map<int, int>::iterator clone = clones.find(~k);
+        if (clone == clones.end()) continue;
+        clones[newIndices[k]] = clone->second;
+        clones.erase(~k);
+    }
+    for (int i = 0; i < static_cast<int>(foundedClones.size()); i++) {
+        if (foundedClones[i] < 0) foundedClones[i] = newIndices[~foundedClones[i]];
+    }
+    for (int i = 0; i < static_cast<int>(extinctClones.size()); i++) {
+        if (extinctClones[i] < 0) extinctClones[i] = newIndices[~extinctClones[i]];
+    }
+    newGenotypes.clear();
+}
+// hand over the clones founded and lost since the last drain
+void Deme::drainCloneChanges(std::vector<int>& founded, std::vector<int>& extinct) {
+    founded.insert(founded.end(), foundedClones.begin(), foundedClones.end());
+    extinct.insert(extinct.end(), extinctClones.begin(), extinctClones.end());
+    foundedClones.clear();
+    extinctClones.clear();
+}
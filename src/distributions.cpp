@@ -1,39 +1,110 @@
 #include "distributions.hpp"
 
-// constructor
-RandomNumberGenerator::RandomNumberGenerator() : rng(std::random_device()()), dist(0.0, 1.0) {}
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
 
-// get instance
-RandomNumberGenerator& RandomNumberGenerator::getInstance() {
-    static RandomNumberGenerator instance;
-    return instance;
+// seed all four state words through SplitMix64
+void RandomNumberGenerator::setSeed(uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        seed += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        state[i] = z ^ (z >> 31);
+    }
 }
 
-// manual seed set
-void RandomNumberGenerator::setSeed(unsigned int seed) {
-    rng.seed(seed);
+// next 64-bit draw
+RandomNumberGenerator::result_type RandomNumberGenerator::operator()() {
+    const uint64_t res = rotl(state[1] * 5, 7) * 9;
+    const uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return res;
+}
+
+// advance the state by the jump polynomial `poly`
+void RandomNumberGenerator::jumpBy(const uint64_t* poly) {
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (poly[i] & (uint64_t(1) << b)) {
+                s0 ^= state[0];
+                s1 ^= state[1];
+                s2 ^= state[2];
+                s3 ^= state[3];
+            }
+            (*this)();
+        }
+    }
+    state[0] = s0;
+    state[1] = s1;
+    state[2] = s2;
+    state[3] = s3;
+}
+// advance the stream by 2^128 draws
+void RandomNumberGenerator::jump() {
+    static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+    jumpBy(JUMP);
+}
+// advance the stream by 2^192 draws
+void RandomNumberGenerator::longJump() {
+    static const uint64_t LONG_JUMP[] = { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+    jumpBy(LONG_JUMP);
+}
+
+// new stream: the current state, with this stream moved on to the next block
+RandomNumberGenerator RandomNumberGenerator::split() {
+    RandomNumberGenerator child = *this;
+    jump();
+    return child;
+}
+// new stream owning the two long-jump blocks of a run (e.g. one per replicate)
+RandomNumberGenerator RandomNumberGenerator::splitRun() {
+    RandomNumberGenerator child = *this;
+    longJump();
+    longJump();
+    return child;
 }
 
 // U(0,1)
 double RandomNumberGenerator::unitUnifDist() {
-    return dist(rng);
+    return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
 }
 
 // Poisson(lambda)
 int RandomNumberGenerator::poissonDist(double lambda) {
     std::poisson_distribution<int> dist(lambda);
-    return dist(rng);
+    return dist(*this);
+}
+
+// Binomial(n, p)
+int RandomNumberGenerator::binomialDist(int n, double p) {
+    std::binomial_distribution<int> dist(n, p);
+    return dist(*this);
 }
 
 // Exp(lambda)
 double RandomNumberGenerator::expDist(double lambda) {
     std::exponential_distribution<double> dist(lambda);
-    return dist(rng);
+    return dist(*this);
+}
+
+// Geometric(p): number of failures before the first success
+int RandomNumberGenerator::geometricDist(double p) {
+    if (p >= 1) return 0;
+    std::geometric_distribution<int> dist(p);
+    return dist(*this);
 }
 
 // stochastic rounding
 int RandomNumberGenerator::stochasticRound(double a) {
-    float rnd = dist(rng);
+    float rnd = unitUnifDist();
     float fractional_part = a - static_cast<int>(a);
     if (rnd < fractional_part) {
         return static_cast<int>(a) + 1;
@@ -76,8 +147,3 @@ unsigned int RandomNumberGenerator::hypergeometricDist(unsigned int n1, unsigned
 
     return k;
 }
-
-// get engine
-std::mt19937 RandomNumberGenerator::getEngine() {
-    return rng;
-}
\ No newline at end of file
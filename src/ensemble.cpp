@@ -0,0 +1,46 @@
+#include "ensemble.hpp"
+
+// run `replicates` independent simulations of one parameter set concurrently,
+// each writing to its own replicate_<i>/ directory
+void runEnsemble(const std::string& input_and_output_path,
+    const InputParameters& params, int replicates, int numThreads, bool resume) {
+    DerivedParameters d_params = deriveParameters(params);
+    InputParameters replicateParams = jobParameters(params);
+    std::vector<RandomNumberGenerator> streams = replicateStreams(params.seed, replicates);
+    std::vector<BatchJob> jobs;
+    for (int i = 0; i < replicates; i++) {
+        jobs.push_back({ "replicate_" + std::to_string(i), [&, i](const std::string& replicatePath) {
+            return runSim(replicatePath, replicateParams, d_params, streams[i], false, resume);
+        } });
+    }
+    std::cout << "Running " << replicates << " replicates on "
+              << ThreadPool::resolveNumThreads(numThreads) << " threads." << std::endl;
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<SimSummary> summaries;
+    bool completed = runBatch(input_and_output_path, jobs, numThreads, summaries,
+        [](int i, const SimSummary& summary) {
+            std::cout << "Replicate " << i << " finished: "
+                      << summary.gensElapsed << " generations; "
+                      << summary.numCells << " cells; "
+                      << summary.runningTime << " seconds." << std::endl;
+        });
+    if (!completed) {
+        std::cout << "Stopped: rerun with --resume to continue." << std::endl;
+        return;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    writeBatchSummary(input_and_output_path + "ensemble_summary.csv", summaries, true);
+    std::cout << "End of ensemble. Running time: " << elapsed.count() << " seconds." << std::endl;
+}
+
+// streams are split in replicate order, so results do not depend on the
+// number of threads and replicate 0 matches a single run with this seed
+std::vector<RandomNumberGenerator> replicateStreams(uint64_t seed, int replicates) {
+    RandomNumberGenerator master(seed);
+    std::vector<RandomNumberGenerator> streams;
+    for (int i = 0; i < replicates; i++) {
+        streams.push_back(master.splitRun());
+    }
+    return streams;
+}
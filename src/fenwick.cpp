@@ -0,0 +1,76 @@
+#include "fenwick.hpp"
+
+/////// Element handling
+// append an element
+void FenwickTree::pushBack(double value) {
+    values.push_back(value);
+    int n = values.size();
+    // node n covers elements (n - lowbit(n), n]
+    tree.push_back(value + prefixSum(n - 1) - prefixSum(n - (n & -n)));
+}
+// remove the last element (no other node covers it)
+void FenwickTree::popBack() {
+    values.pop_back();
+    tree.pop_back();
+}
+// set the weight of element i
+void FenwickTree::set(int i, double value) {
+    double delta = value - values[i];
+    values[i] = value;
+    int n = values.size();
+    for (int k = i + 1; k <= n; k += k & -k) {
+        tree[k] += delta;
+    }
+}
+// remove all elements
+void FenwickTree::clear() {
+    values.clear();
+    tree.assign(1, 0);
+}
+// recompute all partial sums from the element weights in O(n)
+void FenwickTree::rebuild() {
+    int n = values.size();
+    tree.assign(n + 1, 0);
+    for (int k = 1; k <= n; k++) {
+        tree[k] += values[k - 1];
+        int parent = k + (k & -k);
+        if (parent <= n) tree[parent] += tree[k];
+    }
+}
+
+/////// Sums and sampling
+// sum of the first n weights
+double FenwickTree::prefixSum(int n) const {
+    double res = 0;
+    for (int k = n; k > 0; k -= k & -k) {
+        res += tree[k];
+    }
+    return res;
+}
+// index of the element in which cumulative weight r falls
+int FenwickTree::find(double r) const {
+    int n = values.size();
+    int pos = 0;
+    int step = 1;
+    while (step * 2 <= n) step *= 2;
+    for (; step > 0; step /= 2) {
+        if (pos + step <= n && tree[pos + step] <= r) {
+            pos += step;
+            r -= tree[pos];
+        }
+    }
+    // guard against rounding pushing r past the last element
+    return pos < n ? pos : n - 1;
+}
+
+/////// Checkpointing
+// weights and partial sums are stored as-is, so sampling after a restore
+// sees exactly the same rounding as before
+void FenwickTree::save(CheckpointWriter& out) const {
+    out.writeArray(values);
+    out.writeArray(tree);
+}
+void FenwickTree::load(CheckpointReader& in) {
+    values = in.readArray<double>();
+    tree = in.readArray<double>();
+}
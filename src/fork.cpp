@@ -0,0 +1,172 @@
+#include "fork.hpp"
+
+#include <fstream>
+
+// config keys that only act after the growth phase, and so may vary between forks
+bool isForkParameter(const std::string& key) {
+    return key == "rng_seed.seed" || key == "stopping_conditions.turnover" ||
+        key == "methylation.meth_rate" || key == "methylation.demeth_rate";
+}
+
+// simulate the growth phase once, then run one turnover phase per point of the
+// fork spec from a copy of the grown tumour, concurrently on `numThreads` threads
+void runForks(const std::string& input_and_output_path,
+    const boost::property_tree::ptree& basePt, const std::string& fork_file_with_path,
+    int numThreads) {
+    boost::property_tree::ptree forkPt;
+    boost::property_tree::info_parser::read_info(fork_file_with_path, forkPt);
+    std::vector<SweepPoint> forks = expandSweep(basePt, forkPt, fork_file_with_path);
+    for (int a = 0; a < static_cast<int>(forks[0].values.size()); a++) {
+        if (!isForkParameter(forks[0].values[a].first)) {
+            std::cerr << "ERROR: Fork parameter " << forks[0].values[a].first
+                      << " affects the growth phase; only the seed, turnover and"
+                      << " methylation rates can vary between forks." << std::endl;
+            exit(1);
+        }
+    }
+    InputParameters params = readParameters(basePt, fork_file_with_path);
+    DerivedParameters d_params = deriveParameters(params);
+
+    // map of fork directories to parameter values
+    std::ofstream forksFile(input_and_output_path + "fork_points.csv");
+    forksFile << "Fork";
+    for (int a = 0; a < static_cast<int>(forks[0].values.size()); a++) {
+        forksFile << "," << forks[0].values[a].first;
+    }
+    forksFile << std::endl;
+    for (int m = 0; m < static_cast<int>(forks.size()); m++) {
+        forksFile << forks[m].index;
+        for (int a = 0; a < static_cast<int>(forks[m].values.size()); a++) {
+            forksFile << "," << forks[m].values[a].second;
+        }
+        forksFile << std::endl;
+    }
+
+    // shared growth phase
+    auto start = std::chrono::high_resolution_clock::now();
+    Tumour tumour(params, d_params, RandomNumberGenerator(params.seed));
+    std::string growthPath = input_and_output_path + demesFileName("growth_demes", params.demes_format);
+    std::string growthBiopsyPath = input_and_output_path + "growth_biopsies.csv";
+    std::string growthStatsPath = input_and_output_path + "growth_summary_stats.csv";
+    RunState growthState;
+    growthState.nextBiopsy = params.biopsy_interval;
+    growthState.biopsyStream = Sampler::streamFor(tumour.getStream());
+    {
+        FileOutput growthDemes(growthPath, false, params.demes_format, params.output_queue);
+        growthDemes.writeDemesHeader(tumour);
+        std::unique_ptr<Sampler> sampler;
+        std::unique_ptr<FileOutput> growthBiopsies;
+        if (params.biopsy_cells > 0) {
+            sampler.reset(new Sampler(params));
+            growthBiopsies.reset(new FileOutput(growthBiopsyPath));
+            growthBiopsies->writeBiopsiesHeader();
+        }
+        std::unique_ptr<SummaryStats> stats;
+        std::unique_ptr<FileOutput> growthStats;
+        if (params.write_stats_file) {
+            stats.reset(new SummaryStats(params));
+            growthStats.reset(new FileOutput(growthStatsPath));
+            growthStats->writeStatsHeader();
+        }
+        std::unique_ptr<ThreadPool> growthPool;
+        if (params.parallel_demes) growthPool.reset(new ThreadPool(params.num_threads));
+        // forks are not resumable, so the growth phase is not checkpointed
+        InputParameters growthParams = params;
+        growthParams.checkpoint_interval = 0;
+        RunContext context = { growthParams, d_params, growthDemes, growthPool.get(),
+            sampler.get(), growthBiopsies.get(), stats.get(), growthStats.get(), input_and_output_path + "checkpoint.bin", true };
+        if (!runGrowth(tumour, growthState, context)) return;
+        growthDemes.writeDemesFile(tumour);
+        writeStats(tumour, context);
+    }
+    std::chrono::duration<double> growthTime = std::chrono::high_resolution_clock::now() - start;
+
+    // seconds of each fork's own turnover phase
+    std::vector<double> forkTimes(forks.size());
+    std::vector<BatchJob> jobs;
+    for (int m = 0; m < static_cast<int>(forks.size()); m++) {
+        jobs.push_back({ "turnover_" + std::to_string(m), [&, m](const std::string& forkPath) -> SimSummary {
+            auto forkStart = std::chrono::high_resolution_clock::now();
+            InputParameters forkParams = jobParameters(forks[m].params);
+            forkParams.checkpoint_interval = 0;
+            std::string demesPath = forkPath + demesFileName("final_demes", params.demes_format);
+            std::string biopsyPath = forkPath + "biopsies.csv";
+            std::string statsPath = forkPath + "summary_stats.csv";
+            // every fork's demes file starts with the shared growth rows
+            {
+                std::ifstream growthRows(growthPath, std::ios::binary);
+                std::ofstream forkRows(demesPath, std::ios::binary);
+                forkRows << growthRows.rdbuf();
+            }
+            if (params.biopsy_cells > 0) {
+                std::ifstream growthRows(growthBiopsyPath, std::ios::binary);
+                std::ofstream forkRows(biopsyPath, std::ios::binary);
+                forkRows << growthRows.rdbuf();
+            }
+            if (params.write_stats_file) {
+                std::ifstream growthRows(growthStatsPath, std::ios::binary);
+                std::ofstream forkRows(statsPath, std::ios::binary);
+                forkRows << growthRows.rdbuf();
+            }
+            // forks that differ only in turnover or methylation rates share random
+            // numbers; splitRun moves them past the two blocks of the growth
+            // phase run (see distributions.hpp)
+            Tumour fork = tumour;
+            RandomNumberGenerator forkStream(forkParams.seed);
+            forkStream.splitRun();
+            fork.reseed(forkStream);
+            fork.setMethylationRates(forkParams.meth_rate, forkParams.demeth_rate);
+            RunState state = growthState;
+            state.turnoverTime = fork.getGensElapsed() * ( 1 + forkParams.turnover );
+            state.biopsyStream = Sampler::streamFor(fork.getStream());
+
+            FileOutput forkDemes(demesPath, true, params.demes_format, params.output_queue);
+            std::unique_ptr<ThreadPool> forkPool;
+            if (forkParams.parallel_demes) forkPool.reset(new ThreadPool(forkParams.num_threads));
+            std::unique_ptr<Sampler> sampler;
+            std::unique_ptr<FileOutput> forkBiopsies;
+            if (forkParams.biopsy_cells > 0) {
+                sampler.reset(new Sampler(forkParams));
+                forkBiopsies.reset(new FileOutput(biopsyPath, true));
+            }
+            std::unique_ptr<SummaryStats> stats;
+            std::unique_ptr<FileOutput> forkStats;
+            if (params.write_stats_file) {
+                stats.reset(new SummaryStats(forkParams));
+                forkStats.reset(new FileOutput(statsPath, true));
+            }
+            RunContext context = { forkParams, d_params, forkDemes, forkPool.get(),
+                sampler.get(), forkBiopsies.get(), stats.get(), forkStats.get(),
+                forkPath + "checkpoint.bin", false };
+            if (!runTurnover(fork, state, context)) return SimSummary();
+            forkDemes.writeDemesFile(fork);
+            writeStats(fork, context);
+            takeBiopsies(fork, state, context);
+            if (forkParams.write_clones_file) {
+                FileOutput forkCells(forkPath + "final_cells.bin");
+                forkCells.writeCellsFile(fork, forkParams.cells_compression);
+            }
+            std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - forkStart;
+            forkTimes[m] = elapsed.count();
+            return summarise(fork, state, growthTime.count() + elapsed.count());
+        } });
+    }
+    std::cout << "Growth phase finished after " << tumour.getGensElapsed()
+              << " generations; running " << forks.size() << " turnover forks on "
+              << ThreadPool::resolveNumThreads(numThreads) << " threads." << std::endl;
+    std::vector<SimSummary> summaries;
+    bool completed = runBatch(input_and_output_path, jobs, numThreads, summaries,
+        [&](int m, const SimSummary& summary) {
+            std::cout << "Fork " << m << " finished: "
+                      << summary.gensElapsed << " generations; "
+                      << summary.numCells << " cells; "
+                      << forkTimes[m] << " seconds." << std::endl;
+        });
+    if (!completed) {
+        std::cout << "Stopped: forks cannot be resumed." << std::endl;
+        return;
+    }
+    writeBatchSummary(input_and_output_path + "fork_summary.csv", summaries);
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    std::cout << "End of forks. Running time: " << elapsed.count() << " seconds." << std::endl;
+}
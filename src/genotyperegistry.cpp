@@ -0,0 +1,74 @@
+#include "genotyperegistry.hpp"
+
+/////// Genotype handling
+// store a genotype whose parent (if any) is stored; the parent gains a
+// reference, the genotype starts with none; returns its index
+int GenotypeRegistry::add(const Genotype& genotype) {
+    int index;
+    if (freeIndices.empty()) {
+        index = table.size();
+        table.push_back(genotype);
+        refs.push_back(0);
+        live.push_back(1);
+    } else {
+        index = freeIndices.back();
+        freeIndices.pop_back();
+        table[index] = genotype;
+        refs[index] = 0;
+        live[index] = 1;
+    }
+    if (genotype.getParentIndex() >= 0) refs[genotype.getParentIndex()]++;
+    return index;
+}
+// drop a reference; free the genotype and release its parent once unreferenced
+void GenotypeRegistry::release(int index) {
+    while (index >= 0 && --refs[index] == 0) {
+        live[index] = 0;
+        freeIndices.push_back(index);
+        index = table[index].getParentIndex();
+    }
+}
+
+/////// Checkpointing
+// genotypes are written by index; cells refer to them by the same index
+void GenotypeRegistry::save(CheckpointWriter& out) const {
+    out.write<uint64_t>(table.size());
+    for (int i = 0; i < static_cast<int>(table.size()); i++) {
+        out.write<int32_t>(live[i]);
+        if (!live[i]) continue;
+        const Genotype& genotype = table[i];
+        out.write<int32_t>(genotype.getParentIndex());
+        out.write<int32_t>(refs[i]);
+        out.write<int32_t>(genotype.getParent());
+        out.write<int32_t>(genotype.getIdentity());
+        out.write<int32_t>(genotype.getNumBirthMut());
+        out.write<int32_t>(genotype.getNumMigMut());
+        out.write<float>(genotype.getBirthRate());
+        out.write<float>(genotype.getMigrationRate());
+        out.write<float>(genotype.getOriginTime());
+    }
+    out.writeArray(freeIndices);
+}
+// replace the table with one written by save(); driver parameters are kept
+void GenotypeRegistry::load(CheckpointReader& in) {
+    uint64_t size = in.read<uint64_t>();
+    table.assign(size, Genotype(0, 0, 0, 0, 0, 0, 0));
+    refs.assign(size, 0);
+    live.assign(size, 0);
+    for (uint64_t i = 0; i < size; i++) {
+        live[i] = in.read<int32_t>();
+        if (!live[i]) continue;
+        int parentIndex = in.read<int32_t>();
+        refs[i] = in.read<int32_t>();
+        int parent = in.read<int32_t>();
+        int identity = in.read<int32_t>();
+        int numBirthMut = in.read<int32_t>();
+        int numMigMut = in.read<int32_t>();
+        float birthRate = in.read<float>();
+        float migrationRate = in.read<float>();
+        float originTime = in.read<float>();
+        table[i] = Genotype(parent, identity, numBirthMut, numMigMut, birthRate, migrationRate, originTime);
+        table[i].setParentIndex(parentIndex);
+    }
+    freeIndices = in.readArray<int>();
+}
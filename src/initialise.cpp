@@ -16,7 +16,8 @@ DerivedParameters deriveParameters(const InputParameters& params) {
     if (params.left_demes != -1 && params.right_demes != -1) {
         d_params.max_demes = params.left_demes + params.right_demes;
     } else {
-        d_params.max_demes = 8;
+        d_params.max_demes = params.max_demes;
     }
+    d_params.neutral_rates = params.s_driver_birth == 0 && params.s_driver_migration == 0;
     return d_params;
 }
@@ -15,6 +15,29 @@ std::string getInputPath(int argc, char *argv[]) {
     return path;
 }
 
+// parse optional flags after the two positional arguments
+RunOptions parseRunOptions(int argc, char *argv[]) {
+    RunOptions options;
+    for (int i = 3; i < argc; i++) {
+        std::string flag = argv[i];
+        if (flag == "--replicates" && i + 1 < argc) {
+            options.replicates = std::stoi(argv[++i]);
+        } else if (flag == "--threads" && i + 1 < argc) {
+            options.threads = std::stoi(argv[++i]);
+        } else if (flag == "--resume") {
+            options.resume = true;
+        } else if (flag == "--sweep" && i + 1 < argc) {
+            options.sweepFile = argv[++i];
+        } else if (flag == "--fork" && i + 1 < argc) {
+            options.forkFile = argv[++i];
+        } else {
+            std::cerr << "Unknown or incomplete option: " << flag << std::endl;
+            exit(1);
+        }
+    }
+    return options;
+}
+
 // read parameters from config file
 InputParameters readParameters(const boost::property_tree::ptree& pt, const std::string& config_file_path) {
     InputParameters params;
@@ -24,6 +47,7 @@ InputParameters readParameters(const boost::property_tree::ptree& pt, const std:
     params.init_migration_rate = pt.get<float>("dispersal.init_migration_rate");
     params.left_demes = pt.get<int>("dispersal.left_demes");
     params.right_demes = pt.get<int>("dispersal.right_demes");
+    params.max_demes = pt.get<int>("dispersal.max_demes", 8);
     params.migration_rate_scales_with_K = pt.get<int>("dispersal.migration_rate_scales_with_K");
 
     params.mu_driver_birth = pt.get<float>("mutation.mu_driver_birth");
@@ -53,6 +77,31 @@ InputParameters readParameters(const boost::property_tree::ptree& pt, const std:
 
     params.write_demes_file = pt.get<int>("output_indicators.write_demes_file");
     params.write_clones_file = pt.get<int>("output_indicators.write_clones_file");
+    params.demes_format = pt.get<int>("output_indicators.demes_format", 0);
+    if (params.demes_format < 0 || params.demes_format > 2) {
+        std::cerr << "ERROR: output_indicators.demes_format must be 0 (CSV), 1 (float32) or 2 (uint16)." << std::endl;
+        exit(1);
+    }
+    params.output_queue = pt.get<int>("output_indicators.output_queue", 4);
+    params.cells_compression = pt.get<int>("output_indicators.cells_compression", 6);
+    if (params.cells_compression < 0 || params.cells_compression > 9) {
+        std::cerr << "ERROR: output_indicators.cells_compression must be between 0 and 9." << std::endl;
+        exit(1);
+    }
+    params.write_stats_file = pt.get<int>("output_indicators.write_stats_file", 0);
+    params.stats_bins = pt.get<int>("statistics.bins", 20);
+    params.stats_margin = pt.get<float>("statistics.margin", 0.05);
+
+    params.biopsy_cells = pt.get<int>("sampling.cells", 0);
+    params.biopsy_interval = pt.get<float>("sampling.interval", 0);
+    params.biopsy_read_depth = pt.get<float>("sampling.read_depth", 30);
+    params.biopsy_pool_demes = pt.get<int>("sampling.pool_demes", 1);
+    params.biopsy_samples = pt.get<int>("sampling.samples", 1);
+
+    params.checkpoint_interval = pt.get<float>("checkpoint.interval", 0);
+
+    params.num_threads = pt.get<int>("parallel.num_threads", 0);
+    params.parallel_demes = pt.get<int>("parallel.parallel_demes", 0);
 
     return params;
 }
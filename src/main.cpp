@@ -1,20 +1,32 @@
+#include "ensemble.hpp"
+#include "fork.hpp"
 #include "input.hpp"
 #include "initialise.hpp"
 #include "runsim.hpp"
+#include "sweep.hpp"
 
 int main(int argc, char *argv[]) {
     std::string input_and_output_path = getInputPath(argc, argv);
     std::cout << "Input and output directory: " << input_and_output_path << std::endl;
     std::string config_file_with_path = input_and_output_path + argv[2];
     std::cout << "Config file path: " << config_file_with_path << std::endl;
+    RunOptions options = parseRunOptions(argc, argv);
 
     boost::property_tree::ptree pt;
     boost::property_tree::info_parser::read_info(config_file_with_path, pt);
 
     InputParameters params = readParameters(pt, config_file_with_path);
-    RandomNumberGenerator::getInstance().setSeed(params.seed);
+    installStopHandler();
 
-    runSim(input_and_output_path, config_file_with_path, params);
+    if (!options.forkFile.empty()) {
+        runForks(input_and_output_path, pt, input_and_output_path + options.forkFile, options.threads);
+    } else if (!options.sweepFile.empty()) {
+        runSweep(input_and_output_path, pt, input_and_output_path + options.sweepFile, options.threads, options.resume);
+    } else if (options.replicates > 1) {
+        runEnsemble(input_and_output_path, params, options.replicates, options.threads, options.resume);
+    } else {
+        runSim(input_and_output_path, params, deriveParameters(params), RandomNumberGenerator(params.seed), true, options.resume);
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,32 @@
+#include "metharray.hpp"
+
+/////// Word operations
+// number of methylated alleles
+int MethArray::count() const {
+    int res = 0;
+    for (int k = 0; k < getNumWords(); k++) {
+        res += __builtin_popcountll(words[k]);
+    }
+    return res;
+}
+// add the methylated alleles of packed words to per-allele counts, visiting
+// set bits only
+void MethArray::addWordsTo(const uint64_t* words, int numWords, std::vector<int>& counts) {
+    for (int k = 0; k < numWords; k++) {
+        uint64_t word = words[k];
+        while (word) {
+            counts[(k << 6) + __builtin_ctzll(word)]++;
+            word &= word - 1;
+        }
+    }
+}
+// remove the methylated alleles of packed words from per-allele counts
+void MethArray::subtractWordsFrom(const uint64_t* words, int numWords, std::vector<int>& counts) {
+    for (int k = 0; k < numWords; k++) {
+        uint64_t word = words[k];
+        while (word) {
+            counts[(k << 6) + __builtin_ctzll(word)]--;
+            word &= word - 1;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#include "methslab.hpp"
+
+#include <algorithm>
+
+/////// Statistics
+void SlabStats::add(const SlabStats& other) {
+    rowsInUse += other.rowsInUse;
+    rowCapacity += other.rowCapacity;
+    freshRows += other.freshRows;
+    reusedRows += other.reusedRows;
+    copiedRows += other.copiedRows;
+    grows += other.grows;
+}
+SlabStats MethSlab::getStats() const {
+    SlabStats stats;
+    stats.rowsInUse = numRows;
+    stats.rowCapacity = capacity();
+    stats.freshRows = freshRows;
+    stats.reusedRows = reusedRows;
+    stats.copiedRows = copiedRows;
+    stats.grows = grows;
+    return stats;
+}
+
+/////// Row handling
+// reallocate to hold `rows` rows
+void MethSlab::grow(int rows) {
+    words.resize(static_cast<size_t>(rows) * rowWords);
+    grows++;
+}
+// make room for `rows` rows without further reallocation; a full slab then
+// grows by `growRows` rows at a time
+void MethSlab::reserve(int rows, int growRows) {
+    this->growRows = std::max(growRows, 1);
+    if (rows > capacity()) grow(rows);
+}
+// take the first free row; its contents are unspecified
+uint64_t* MethSlab::append() {
+    if (numRows == capacity()) grow(numRows + growRows);
+    if (numRows < usedRows) {
+        reusedRows++;
+    } else {
+        freshRows++;
+        usedRows++;
+    }
+    return row(numRows++);
+}
+// append a copy of row i; returns the index of the copy
+int MethSlab::appendCopy(int i) {
+    uint64_t* copy = append();
+    std::copy(row(i), row(i) + rowWords, copy);
+    copiedRows++;
+    return numRows - 1;
+}
+// append a copy of row i of another slab with the same row size
+int MethSlab::appendFrom(const MethSlab& source, int i) {
+    std::copy(source.row(i), source.row(i) + rowWords, append());
+    copiedRows++;
+    return numRows - 1;
+}
+// free row i by moving the last row into its place
+void MethSlab::swapRemove(int i) {
+    int last = numRows - 1;
+    if (i != last) std::copy(row(last), row(last) + rowWords, row(i));
+    numRows--;
+}
+// replace the rows with packed row data, e.g. from a checkpoint
+void MethSlab::assign(const std::vector<uint64_t>& rowData) {
+    numRows = rowWords ? rowData.size() / rowWords : 0;
+    usedRows = numRows;
+    words = rowData;
+}
@@ -1,21 +1,314 @@
 #include "output.hpp"
 
-void FileOutput::writeDemesHeader() {
-    file << "Generation,Deme,Side,Population,OriginTime,AverageArray" << std::endl;
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef METHDEMON_ZLIB
+#include <zlib.h>
+#endif
+
+/////// Snapshots
+// copy the state of every deme
+void DemesSnapshot::take(Tumour& tumour) {
+    generation = tumour.getGensElapsed();
+    numDemes = tumour.getNumDemes();
+    if (static_cast<int>(demes.size()) < numDemes) demes.resize(numDemes);
+    for (int i = 0; i < numDemes; i++) {
+        const Deme& deme = tumour.getDeme(i);
+        demes[i].side = deme.getSide();
+        demes[i].population = deme.getPopulation();
+        demes[i].originTime = deme.getOriginTime();
+        demes[i].methCounts.assign(deme.getMethCounts().begin(), deme.getMethCounts().end());
+    }
+}
+
+/////// Constructor and destructor
+FileOutput::FileOutput(const std::string& path, bool append, int demesFormat, int queueSize)
+    : demesFormat(demesFormat), stopping(false) {
+    file.open(path, (append ? std::ofstream::app : std::ofstream::out) | std::ofstream::binary);
+    if (queueSize > 0) {
+        queue.reset(new SpscQueue<DemesSnapshot>(queueSize));
+        writer = std::thread(&FileOutput::writerLoop, this);
+    }
+}
+// queued snapshots are written before the file is closed
+FileOutput::~FileOutput() {
+    if (queue) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        published.notify_one();
+        writer.join();
+    }
+    file.close();
+}
+
+/////// Background writer
+// write queued snapshots in order until stopped and the queue is empty
+void FileOutput::writerLoop() {
+    while (true) {
+        DemesSnapshot* next = queue->front();
+        if (next) {
+            writeSnapshot(*next);
+            queue->pop();
+            { std::lock_guard<std::mutex> lock(mutex); }
+            released.notify_one();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        published.wait(lock, [this] { return stopping || !queue->empty(); });
+        if (stopping && queue->empty()) return;
+    }
 }
+// wait until every queued snapshot has been written
+void FileOutput::drain() {
+    if (!queue) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [this] { return queue->empty(); });
+}
+
+/////// Demes file
+// size of one binary record, padded so that records stay 8-byte aligned
+int FileOutput::getRecordBytes(int sites) const {
+    int bytes = 20 + sites * (demesFormat == DEMES_UINT16 ? 2 : 4);
+    return (bytes + 7) / 8 * 8;
+}
+// the header is written before any snapshot is queued
+void FileOutput::writeDemesHeader(Tumour& tumour) {
+    if (demesFormat == DEMES_CSV) {
+        file << "Generation,Deme,Side,Population,OriginTime,AverageArray" << std::endl;
+        return;
+    }
+    uint32_t sites = tumour.getDeme(0).getNumSites();
+    uint32_t fields[4] = { DEMES_VERSION, static_cast<uint32_t>(demesFormat), sites,
+        static_cast<uint32_t>(getRecordBytes(sites)) };
+    char padding[8] = {};
+    file.write(DEMES_MAGIC, sizeof(DEMES_MAGIC));
+    file.write(reinterpret_cast<const char*>(fields), sizeof(fields));
+    file.write(padding, sizeof(padding));
+    file.flush();
+}
+// snapshot the demes and queue them for the writer, waiting only while the
+// queue is full, or write them directly if there is no writer
 void FileOutput::writeDemesFile(Tumour& tumour) {
+    if (!queue) {
+        snapshot.take(tumour);
+        writeSnapshot(snapshot);
+        return;
+    }
+    DemesSnapshot* slot = queue->back();
+    if (!slot) {
+        std::unique_lock<std::mutex> lock(mutex);
+        released.wait(lock, [this] { return !queue->full(); });
+        slot = queue->back();
+    }
+    slot->take(tumour);
+    queue->push();
+    { std::lock_guard<std::mutex> lock(mutex); }
+    published.notify_one();
+}
+// rows are formatted from each deme's methylation counts, and the file is
+// flushed once per snapshot rather than once per row; binary records of all
+// demes are assembled in one buffer and written with a single call
+void FileOutput::writeSnapshot(const DemesSnapshot& snapshot) {
+    if (demesFormat != DEMES_CSV) {
+        int sites = snapshot.numDemes ? snapshot.demes[0].getNumSites() : 0;
+        int recordBytes = getRecordBytes(sites);
+        buffer.assign(static_cast<size_t>(recordBytes) * snapshot.numDemes, 0);
+        for (int i = 0; i < snapshot.numDemes; i++) {
+            const DemeSnapshot& deme = snapshot.demes[i];
+            char* record = buffer.data() + static_cast<size_t>(recordBytes) * i;
+            float generation = snapshot.generation;
+            int32_t fields[3] = { i, deme.side == "right", deme.population };
+            float originTime = deme.originTime;
+            std::memcpy(record, &generation, 4);
+            std::memcpy(record + 4, fields, 12);
+            std::memcpy(record + 16, &originTime, 4);
+            char* values = record + 20;
+            for (int j = 0; j < sites; j++) {
+                float beta = deme.getAverageSite(j);
+                if (demesFormat == DEMES_UINT16) {
+                    uint16_t scaled = std::lround(beta * 65535);
+                    std::memcpy(values + 2 * j, &scaled, 2);
+                } else {
+                    std::memcpy(values + 4 * j, &beta, 4);
+                }
+            }
+        }
+        file.write(buffer.data(), buffer.size());
+        file.flush();
+        return;
+    }
+    for (int i = 0; i < snapshot.numDemes; i++) {
+        const DemeSnapshot& deme = snapshot.demes[i];
+        file << snapshot.generation << "," << i << ","
+             << deme.side << ","
+             << deme.population << ","
+             << deme.originTime << ",";
+        for (int j = 0; j < deme.getNumSites(); j++) {
+            file << deme.getAverageSite(j) << ";";
+        }
+        file << '\n';
+    }
+    file.flush();
+}
+
+/////// Cells file
+#ifdef METHDEMON_ZLIB
+// deflate consecutive byte ranges into a single zlib stream
+static void deflateParts(const char* const* parts, const uint64_t* sizes, int numParts, int level, std::vector<char>& out) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (deflateInit(&stream, level) != Z_OK) {
+        std::cout << "ERROR: Cannot initialise zlib at compression level " << level << "." << std::endl;
+        exit(1);
+    }
+    uint64_t total = 0;
+    for (int p = 0; p < numParts; p++) total += sizes[p];
+    out.resize(deflateBound(&stream, total));
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = out.size();
+    for (int p = 0; p < numParts; p++) {
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(parts[p]));
+        stream.avail_in = sizes[p];
+        int flush = p == numParts - 1 ? Z_FINISH : Z_NO_FLUSH;
+        while (stream.avail_in > 0 || flush == Z_FINISH) {
+            int status = deflate(&stream, flush);
+            if (status == Z_STREAM_END) break;
+            if (status != Z_OK) {
+                std::cout << "ERROR: zlib failed to compress the cells file (" << status << ")." << std::endl;
+                exit(1);
+            }
+        }
+    }
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+}
+#endif
+// write the cells of every deme, one chunk per deme; columns are written
+// straight from the deme's cell store, so only one deme's compressed chunk
+// and genotype IDs are held at a time
+void FileOutput::writeCellsFile(Tumour& tumour, int compression) {
+#ifndef METHDEMON_ZLIB
+    compression = 0;
+#endif
+    const GenotypeRegistry& genotypes = tumour.getGenotypes();
+    const CellStore& first = tumour.getDeme(0).getCells();
+    uint32_t header[6] = { CELLS_VERSION, static_cast<uint32_t>(first.getFCpGs()),
+        static_cast<uint32_t>(first.getRowWords()), static_cast<uint32_t>(tumour.getNumDemes()), 0, 0 };
+    float generation = tumour.getGensElapsed();
+    std::memcpy(&header[4], &generation, 4);
+    file.write(CELLS_MAGIC, sizeof(CELLS_MAGIC));
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    std::vector<int32_t> genotypeIDs;
     for (int i = 0; i < tumour.getNumDemes(); i++) {
-      file << tumour.getGensElapsed() << "," << i << ","
-           << tumour.getDeme(i).getSide() << ","
-           << tumour.getDeme(i).getPopulation() << ","
-           << tumour.getDeme(i).getOriginTime() << ",";
-      for (int j = 0; j < tumour.getDeme(i).getAverageArray().size(); j++) {
-        file << tumour.getDeme(i).getAverageArray()[j] << ";";
+        const CellStore& cells = tumour.getDeme(i).getCells();
+        int n = cells.size();
+        genotypeIDs.resize(n);
+        for (int k = 0; k < n; k++) {
+            genotypeIDs[k] = genotypes[cells.getGenotype(k)].getIdentity();
+        }
+        const char* parts[5] = {
+            reinterpret_cast<const char*>(cells.getIdentities().data()),
+            reinterpret_cast<const char*>(genotypeIDs.data()),
+            reinterpret_cast<const char*>(cells.getNumMeths().data()),
+            reinterpret_cast<const char*>(cells.getNumDemeths().data()),
+            n ? reinterpret_cast<const char*>(cells.getRow(0)) : nullptr };
+        uint64_t sizes[5] = { 4ull * n, 4ull * n, 4ull * n, 4ull * n,
+            8ull * n * cells.getRowWords() };
+        uint64_t rawBytes = 0;
+        for (int p = 0; p < 5; p++) rawBytes += sizes[p];
+        uint64_t storedBytes = rawBytes;
+#ifdef METHDEMON_ZLIB
+        if (compression > 0 && n > 0) {
+            deflateParts(parts, sizes, 5, compression, buffer);
+            storedBytes = buffer.size();
+        }
+#endif
+        uint32_t chunk[4] = { static_cast<uint32_t>(i), static_cast<uint32_t>(n),
+            static_cast<uint32_t>(compression > 0 && n > 0), 0 };
+        file.write(reinterpret_cast<const char*>(chunk), sizeof(chunk));
+        file.write(reinterpret_cast<const char*>(&rawBytes), 8);
+        file.write(reinterpret_cast<const char*>(&storedBytes), 8);
+        if (chunk[2]) {
+            file.write(buffer.data(), storedBytes);
+        } else {
+            for (int p = 0; p < 5; p++) if (sizes[p]) file.write(parts[p], sizes[p]);
+        }
+    }
+    file.flush();
+}
+
+/////// Other files
+
+// one row per biopsy; Depth and Beta (methylated fraction of reads) are
+// ';'-separated lists over the fCpG sites, with NA for sites without reads
+void FileOutput::writeBiopsiesHeader() {
+    file << "Generation,Side,FirstDeme,NumDemes,Sample,Cells,Depth,Beta" << std::endl;
+}
+void FileOutput::writeBiopsy(const Biopsy& biopsy) {
+    file << biopsy.generation << "," << biopsy.side << "," << biopsy.firstDeme << ","
+         << biopsy.numDemes << "," << biopsy.sample << "," << biopsy.cells << ",";
+    for (int j = 0; j < static_cast<int>(biopsy.depth.size()); j++) {
+        file << (j ? ";" : "") << biopsy.depth[j];
+    }
+    file << ",";
+    for (int j = 0; j < static_cast<int>(biopsy.depth.size()); j++) {
+        file << (j ? ";" : "");
+        if (biopsy.depth[j]) file << static_cast<float>(biopsy.methReads[j]) / biopsy.depth[j];
+        else file << "NA";
+    }
+    file << std::endl;
+}
+// one row per deme and one for the whole tumour (Deme "all") per output time;
+// Histogram is the ';'-separated number of sites per beta bin
+void FileOutput::writeStatsHeader() {
+    file << "Generation,Deme,Side,Population,MeanMeth,VarMeth,MeanDemeth,VarDemeth,"
+         << "MeanBeta,VarBeta,Fluctuating,Correlation,Histogram" << std::endl;
+}
+void FileOutput::writeStats(const SummaryStats& stats) {
+    for (int i = 0; i <= static_cast<int>(stats.demes.size()); i++) {
+        const MethStats& row = i < static_cast<int>(stats.demes.size()) ? stats.demes[i] : stats.tumour;
+        file << stats.generation << "," << row.label << "," << row.side << ","
+             << row.population << "," << row.numMeth.mean << "," << row.numMeth.variance() << ","
+             << row.numDemeth.mean << "," << row.numDemeth.variance() << ","
+             << row.beta.mean << "," << row.beta.variance() << ","
+             << row.fluctuating << "," << row.correlation << ",";
+        for (int b = 0; b < static_cast<int>(row.betaHist.counts.size()); b++) {
+            file << (b ? ";" : "") << row.betaHist.counts[b];
         }
         file << std::endl;
     }
 }
+void FileOutput::writeSummaryHeader() {
+    file << "Run,Generations,Demes,Cells,MeanFissions,Iterations,RunningTime" << std::endl;
+}
+void FileOutput::writeSummaryRow(const std::string& label, const SimSummary& summary) {
+    file << label << "," << summary.gensElapsed << "," << summary.numDemes << ","
+         << summary.numCells << "," << summary.fissionsPerDeme << ","
+         << summary.iterations << "," << summary.runningTime << std::endl;
+}
 
-void FileOutput::writeCellsFile(Tumour& tumour) {
-    return;
+/////// File handling
+// name of a demes file for the given format, e.g. final_demes.csv
+std::string demesFileName(const std::string& stem, int demesFormat) {
+    return stem + (demesFormat == DEMES_CSV ? ".csv" : ".bin");
+}
+// create a directory if it does not exist yet
+bool makeDirectory(const std::string& path) {
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+bool fileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+// cut a file back to `size` bytes (e.g. rows written after a checkpoint)
+void truncateFile(const std::string& path, long size) {
+    if (truncate(path.c_str(), size) != 0) {
+        std::cout << "ERROR: Cannot truncate " << path << std::endl;
+        exit(1);
+    }
 }
@@ -1,103 +1,310 @@
 #include "runsim.hpp"
 
+#include <sys/resource.h>
+
 float calculateTime(Tumour& tumour) {
     // implement calculations for gensAdded
     float tmp = tumour.sumAllRates();
-    float rnd = RandomNumberGenerator::getInstance().expDist(1);
+    float rnd = tumour.getStream().expDist(1);
 
     return rnd / tmp;
 }
 
-void runSim(const std::string& input_and_output_path,
-    const std::string& config_file_with_path, const InputParameters& params) {
-    int iterations = 0;
-    float outputTimer = 0;
+void printProgress(Tumour& tumour, long iterations) {
+    std::cout << "Generations elapsed: " << tumour.getGensElapsed()
+              << ", Iterations: " << iterations
+              << ", Mean Fissions: " << tumour.getFissionsPerDeme()
+              << std::endl;
+    std::cout << "Number of cells: " << tumour.getNumCells() << std::endl;
+    std::cout << "Number of driver genotypes: " << tumour.getNumGenotypes()
+              << " (" << tumour.getNumClones() << " clones across demes)"
+              << std::endl;
+    std::cout << "Number of demes: " << tumour.getNumDemes() << std::endl;
+    std::cout << tumour.getNextCellID() << " cells ever created; "
+              << tumour.getNextGenotypeID() << " genotypes ever created."
+              << std::endl;
+}
+
+// write the tumour and run-loop state to `path`
+void writeCheckpoint(const std::string& path, const Tumour& tumour, const RunState& state) {
+    CheckpointWriter out;
+    tumour.save(out);
+    out.write<int64_t>(state.iterations);
+    out.write<double>(state.outputTimer);
+    out.write<float>(state.turnoverTime);
+    out.write<float>(state.nextCheckpoint);
+    out.write<int64_t>(state.demesFileOffset);
+    out.write<float>(state.nextBiopsy);
+    out.write<int64_t>(state.biopsyFileOffset);
+    for (int i = 0; i < 4; i++) out.write<uint64_t>(state.biopsyStream.getState(i));
+    out.write<int64_t>(state.statsFileOffset);
+    if (!out.saveTo(path)) {
+        std::cout << "ERROR: Cannot write checkpoint " << path << std::endl;
+        exit(1);
+    }
+}
+// restore the tumour and run-loop state from `path`
+void readCheckpoint(const std::string& path, Tumour& tumour, RunState& state, const InputParameters& params, const DerivedParameters& d_params) {
+    CheckpointReader in(path);
+    tumour.load(in, params, d_params);
+    state.iterations = in.read<int64_t>();
+    state.outputTimer = in.read<double>();
+    state.turnoverTime = in.read<float>();
+    state.nextCheckpoint = in.read<float>();
+    state.demesFileOffset = in.read<int64_t>();
+    state.nextBiopsy = in.read<float>();
+    state.biopsyFileOffset = in.read<int64_t>();
+    for (int i = 0; i < 4; i++) state.biopsyStream.setState(i, in.read<uint64_t>());
+    state.statsFileOffset = in.read<int64_t>();
+}
+// summary statistics, written at every output time
+void writeStats(Tumour& tumour, RunContext& context) {
+    if (!context.stats) return;
+    context.stats->take(tumour);
+    context.statsFile->writeStats(*context.stats);
+}
+// biopsies of the tumour as it is now, from the biopsy stream
+void takeBiopsies(Tumour& tumour, RunState& state, RunContext& context) {
+    if (!context.sampler) return;
+    std::vector<Biopsy> biopsies = context.sampler->takeBiopsies(tumour, state.biopsyStream);
+    for (int b = 0; b < static_cast<int>(biopsies.size()); b++) {
+        context.biopsyFile->writeBiopsy(biopsies[b]);
+    }
+}
+// periodic biopsies, taken after complete loop iterations like checkpoints
+void biopsyIfDue(Tumour& tumour, RunState& state, RunContext& context) {
+    float interval = context.params.biopsy_interval;
+    if (!context.sampler || interval <= 0 || tumour.getGensElapsed() < state.nextBiopsy) return;
+    while (state.nextBiopsy <= tumour.getGensElapsed()) state.nextBiopsy += interval;
+    takeBiopsies(tumour, state, context);
+}
+// checkpoints are written after complete loop iterations, periodically and
+// when a stop is requested; returns true if the run should stop
+bool checkpointIfDue(Tumour& tumour, RunState& state, RunContext& context) {
+    float interval = context.params.checkpoint_interval;
+    bool due = interval > 0 && tumour.getGensElapsed() >= state.nextCheckpoint;
+    if (!due && !stopRequested()) return false;
+    while (interval > 0 && state.nextCheckpoint <= tumour.getGensElapsed()) {
+        state.nextCheckpoint += interval;
+    }
+    state.demesFileOffset = context.demesFile.getPosition();
+    if (context.biopsyFile) state.biopsyFileOffset = context.biopsyFile->getPosition();
+    if (context.statsFile) state.statsFileOffset = context.statsFile->getPosition();
+    writeCheckpoint(context.checkpointPath, tumour, state);
+    if (stopRequested()) {
+        std::cout << "Stop requested: checkpoint written at generation "
+                  << tumour.getGensElapsed() << "." << std::endl;
+        return true;
+    }
+    return false;
+}
+
+// growth phase: until max_fissions per deme and max_demes are reached;
+// returns false if the run was stopped
+template<typename Rates>
+static bool growthPhase(Tumour& tumour, RunState& state, RunContext& context) {
+    const InputParameters& params = context.params;
+    const DerivedParameters& d_params = context.d_params;
     float gensAdded; // time tracking
-    // derive derived parameters
-    DerivedParameters d_params = deriveParameters(params);
-    // initialise output files
-    FileOutput finalDemes(input_and_output_path + "final_demes.csv");
-    finalDemes.writeDemesHeader();
-    // initialise tumour
-    Tumour tumour(params, d_params);
-    // NOTE: Implement event counter eventually (not that important tbh)
-    std::cout << "Initialised simulation." << std::endl;
-    // start timer
-    auto start = std::chrono::high_resolution_clock::now();
     // sort out column headers in output files
-    while(tumour.getFissionsPerDeme() < params.max_fissions ||
-            tumour.getNumDemes() < d_params.max_demes) {
-        tumour.event(params, d_params);
+    while((tumour.getFissionsPerDeme() < params.max_fissions ||
+            tumour.getNumDemes() < d_params.max_demes) &&
+            !(context.pool && tumour.getNumDemes() >= d_params.max_demes)) {
+        tumour.template event<Rates>(params, d_params);
 
         // update time
-        iterations++;
+        state.iterations++;
         gensAdded = calculateTime(tumour);
         tumour.setGensElapsed(gensAdded);
-        outputTimer += gensAdded;
+        state.outputTimer += gensAdded;
 
         // write to stdout and files every 10 generations
-        if(outputTimer >= 10) {
-            int numGenotypes = tumour.getNumGenotypes();
-            int numDemes = tumour.getNumDemes();
-            int numCells = tumour.getNumCells();
-            std::cout << "Generations elapsed: " << tumour.getGensElapsed()
-                      << ", Iterations: " << iterations
-                      << ", Mean Fissions: " << tumour.getFissionsPerDeme()
-                      << std::endl;
-            std::cout << "Number of cells: " << numCells << std::endl;
-            std::cout << "Number of driver genotypes: " << numGenotypes
-                      << std::endl;
-            std::cout << "Number of demes: " << numDemes << std::endl;
-            std::cout << tumour.getNextCellID() << " cells ever created; "
-                      << tumour.getNextGenotypeID()
-                      << " genotypes ever created." << std::endl;
-            outputTimer = 0;
-            if (params.write_demes_file) finalDemes.writeDemesFile(tumour);
+        if(state.outputTimer >= 10) {
+            if (context.verbose) printProgress(tumour, state.iterations);
+            state.outputTimer = 0;
+            if (params.write_demes_file) context.demesFile.writeDemesFile(tumour);
+            writeStats(tumour, context);
         }
+        biopsyIfDue(tumour, state, context);
+        if (checkpointIfDue(tumour, state, context)) return false;
     }
 
-    float turnoverTime = tumour.getGensElapsed() * ( 1 + params.turnover );
-    std::cout << "Turnover start time: " << tumour.getGensElapsed()
-        << std::endl;
-    std::cout << "Turnover end time: " << turnoverTime << std::endl;
+    // every deme now exists and fissions only halve the chosen deme, so demes
+    // interact only through the mean-fission stopping condition, which is
+    // checked at a synchronisation barrier every generation
+    if (context.pool) {
+        while(tumour.getFissionsPerDeme() < params.max_fissions) {
+            state.iterations += tumour.template advanceDemes<Rates>(tumour.getGensElapsed() + 1, *context.pool, params);
+            state.outputTimer += 1;
+            if(state.outputTimer >= 10) {
+                if (context.verbose) printProgress(tumour, state.iterations);
+                state.outputTimer = 0;
+                if (params.write_demes_file) context.demesFile.writeDemesFile(tumour);
+                writeStats(tumour, context);
+            }
+            biopsyIfDue(tumour, state, context);
+            if (checkpointIfDue(tumour, state, context)) return false;
+        }
+    }
+
+    state.turnoverTime = tumour.getGensElapsed() * ( 1 + params.turnover );
     tumour.setTurnoverIndicator();
-    while(tumour.getGensElapsed() < turnoverTime) {
-      tumour.event(params, d_params);
+    return true;
+}
+
+// turnover phase: until state.turnoverTime; returns false if the run was stopped
+template<typename Rates>
+static bool turnoverPhase(Tumour& tumour, RunState& state, RunContext& context) {
+    const InputParameters& params = context.params;
+    const DerivedParameters& d_params = context.d_params;
+    float gensAdded; // time tracking
+    if (context.verbose) {
+        std::cout << "Turnover start time: " << tumour.getGensElapsed()
+            << std::endl;
+        std::cout << "Turnover end time: " << state.turnoverTime << std::endl;
+    }
+    if (context.pool) {
+        // demes no longer interact: advance them concurrently between output times
+        while(tumour.getGensElapsed() < state.turnoverTime) {
+            float horizon = min(tumour.getGensElapsed() + 5, state.turnoverTime);
+            state.iterations += tumour.template advanceDemes<Rates>(horizon, *context.pool, params);
+            if (context.verbose) printProgress(tumour, state.iterations);
+            if (params.write_demes_file) context.demesFile.writeDemesFile(tumour);
+            writeStats(tumour, context);
+            biopsyIfDue(tumour, state, context);
+            if (checkpointIfDue(tumour, state, context)) return false;
+        }
+    }
+    while(tumour.getGensElapsed() < state.turnoverTime) {
+      tumour.template event<Rates>(params, d_params);
 
       // update time
-      iterations++;
+      state.iterations++;
       gensAdded = calculateTime(tumour);
       tumour.setGensElapsed(gensAdded);
-      outputTimer += gensAdded;
+      state.outputTimer += gensAdded;
 
       // write to stdout and files every 5 generations
-      if (outputTimer >= 5) {
-        int numGenotypes = tumour.getNumGenotypes();
-        int numDemes = tumour.getNumDemes();
-        int numCells = tumour.getNumCells();
-        std::cout << "Generations elapsed: " << tumour.getGensElapsed()
-                  << ", Iterations: " << iterations
-                  << ", Mean Fissions: " << tumour.getFissionsPerDeme()
-                  << std::endl;
-        std::cout << "Number of cells: " << numCells << std::endl;
-        std::cout << "Number of driver genotypes: " << numGenotypes
-                  << std::endl;
-        std::cout << "Number of demes: " << numDemes << std::endl;
-        std::cout << tumour.getNextCellID() << " cells ever created; "
-                  << tumour.getNextGenotypeID() << " genotypes ever created."
-                  << std::endl;
-        outputTimer = 0;
+      if (state.outputTimer >= 5) {
+        if (context.verbose)
+          printProgress(tumour, state.iterations);
+        state.outputTimer = 0;
         if (params.write_demes_file)
-          finalDemes.writeDemesFile(tumour);
+          context.demesFile.writeDemesFile(tumour);
+        writeStats(tumour, context);
         }
+      biopsyIfDue(tumour, state, context);
+      if (checkpointIfDue(tumour, state, context))
+        return false;
     }
+    return true;
+}
 
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed = end - start;
+// the rate policy is chosen once per phase, so the event loops are compiled
+// separately for neutral and selective runs
+bool runGrowth(Tumour& tumour, RunState& state, RunContext& context) {
+    if (context.d_params.neutral_rates) return growthPhase<NeutralRates>(tumour, state, context);
+    return growthPhase<SelectiveRates>(tumour, state, context);
+}
+bool runTurnover(Tumour& tumour, RunState& state, RunContext& context) {
+    if (context.d_params.neutral_rates) return turnoverPhase<NeutralRates>(tumour, state, context);
+    return turnoverPhase<SelectiveRates>(tumour, state, context);
+}
+
+// end-of-run statistics
+SimSummary summarise(Tumour& tumour, const RunState& state, double runningTime) {
+    SimSummary summary;
+    summary.gensElapsed = tumour.getGensElapsed();
+    summary.numDemes = tumour.getNumDemes();
+    summary.numCells = tumour.getNumCells();
+    summary.fissionsPerDeme = tumour.getFissionsPerDeme();
+    summary.iterations = state.iterations;
+    summary.runningTime = runningTime;
+    return summary;
+}
+void printSummary(Tumour& tumour, const SimSummary& summary) {
     std::cout << "End of simulation." << std::endl
     << tumour.getNumDemes() << " demes; " << tumour.getNumCells() << " cells; "
     << tumour.getGensElapsed() << " generations; "
     << tumour.getFissionsPerDeme() << " mean fissions per deme." << std::endl;
-    std::cout << "Running time: " << elapsed.count() << " seconds." << std::endl;
+    std::cout << "Running time: " << summary.runningTime << " seconds; "
+    << summary.iterations / summary.runningTime << " events per second." << std::endl;
+    std::cout << "Rate re-summations: " << tumour.getRateResums()
+    << "; max rate-sum drift: " << tumour.getMaxRateDrift() << std::endl;
+    SlabStats slab = tumour.getSlabStats();
+    std::cout << "Methylation rows: " << slab.rowsInUse << " in use of "
+    << slab.rowCapacity << " allocated; " << slab.reusedRows << " reused and "
+    << slab.freshRows << " fresh rows handed out; " << slab.copiedRows << " rows copied; "
+    << slab.grows << " slab grows." << std::endl;
+    // ru_maxrss is in kilobytes on Linux
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "Peak memory: " << usage.ru_maxrss / 1024 << " MB" << std::endl;
+}
+
+SimSummary runSim(const std::string& input_and_output_path,
+    const InputParameters& params, const DerivedParameters& d_params,
+    const RandomNumberGenerator& stream, bool verbose, bool resume) {
+    // initialise tumour, or restore it from the last checkpoint
+    Tumour tumour(params, d_params, stream);
+    std::string checkpointPath = input_and_output_path + "checkpoint.bin";
+    std::string demesPath = input_and_output_path + demesFileName("final_demes", params.demes_format);
+    std::string biopsyPath = input_and_output_path + "biopsies.csv";
+    std::string statsPath = input_and_output_path + "summary_stats.csv";
+    RunState state;
+    state.nextCheckpoint = params.checkpoint_interval;
+    state.nextBiopsy = params.biopsy_interval;
+    state.biopsyStream = Sampler::streamFor(tumour.getStream());
+    bool resumed = resume && fileExists(checkpointPath);
+    if (resumed) {
+        readCheckpoint(checkpointPath, tumour, state, params, d_params);
+        // drop rows written after the checkpoint; they are written again
+        truncateFile(demesPath, state.demesFileOffset);
+        if (params.biopsy_cells > 0) truncateFile(biopsyPath, state.biopsyFileOffset);
+        if (params.write_stats_file) truncateFile(statsPath, state.statsFileOffset);
+        if (verbose) std::cout << "Resumed from checkpoint at generation "
+            << tumour.getGensElapsed() << "." << std::endl;
+    }
+    // initialise output files
+    FileOutput finalDemes(demesPath, resumed, params.demes_format, params.output_queue);
+    if (!resumed) finalDemes.writeDemesHeader(tumour);
+    std::unique_ptr<Sampler> sampler;
+    std::unique_ptr<FileOutput> biopsies;
+    if (params.biopsy_cells > 0) {
+        sampler.reset(new Sampler(params));
+        biopsies.reset(new FileOutput(biopsyPath, resumed));
+        if (!resumed) biopsies->writeBiopsiesHeader();
+    }
+    std::unique_ptr<SummaryStats> stats;
+    std::unique_ptr<FileOutput> statsFile;
+    if (params.write_stats_file) {
+        stats.reset(new SummaryStats(params));
+        statsFile.reset(new FileOutput(statsPath, resumed));
+        if (!resumed) statsFile->writeStatsHeader();
+    }
+    // NOTE: Implement event counter eventually (not that important tbh)
+    if (verbose) std::cout << "Initialised simulation." << std::endl;
+    // start timer
+    auto start = std::chrono::high_resolution_clock::now();
+    // worker threads for independent-deme phases
+    std::unique_ptr<ThreadPool> pool;
+    if (params.parallel_demes) pool.reset(new ThreadPool(params.num_threads));
+    RunContext context = { params, d_params, finalDemes, pool.get(), sampler.get(), biopsies.get(),
+        stats.get(), statsFile.get(), checkpointPath, verbose };
+
+    bool finished = (tumour.getTurnoverIndicator() || runGrowth(tumour, state, context))
+        && runTurnover(tumour, state, context);
+
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    SimSummary summary = summarise(tumour, state, elapsed.count());
+    if (!finished) return summary;
+    if (verbose) printSummary(tumour, summary);
     finalDemes.writeDemesFile(tumour);
+    writeStats(tumour, context);
+    takeBiopsies(tumour, state, context);
+    if (params.write_clones_file) {
+        FileOutput finalCells(input_and_output_path + "final_cells.bin");
+        finalCells.writeCellsFile(tumour, params.cells_compression);
+    }
+    return summary;
 }
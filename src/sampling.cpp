@@ -0,0 +1,75 @@
+#include "sampling.hpp"
+
+/////// Constructor
+Sampler::Sampler(const InputParameters& params)
+    : cells(params.biopsy_cells), readDepth(params.biopsy_read_depth),
+      poolDemes(max(params.biopsy_pool_demes, 1)), samples(max(params.biopsy_samples, 1)) {}
+
+/////// Biopsies
+// biopsies of every window of adjacent demes of each side, in deme order
+std::vector<Biopsy> Sampler::takeBiopsies(Tumour& tumour, RandomNumberGenerator& rng) {
+    std::vector<Biopsy> res;
+    const char* sides[2] = { "left", "right" };
+    for (int s = 0; s < 2; s++) {
+        std::vector<int> sideDemes;
+        for (int i = 0; i < tumour.getNumDemes(); i++) {
+            if (tumour.getDeme(i).getSide() == sides[s]) sideDemes.push_back(i);
+        }
+        for (int w = 0; w < static_cast<int>(sideDemes.size()); w += poolDemes) {
+            window.assign(sideDemes.begin() + w, sideDemes.begin() + min(w + poolDemes, static_cast<int>(sideDemes.size())));
+            for (int k = 0; k < samples; k++) {
+                res.push_back(Biopsy());
+                Biopsy& b = res.back();
+                b.generation = tumour.getGensElapsed();
+                b.side = sides[s];
+                b.firstDeme = window.front();
+                b.numDemes = window.size();
+                b.sample = k;
+                biopsy(tumour, rng, b);
+            }
+        }
+    }
+    return res;
+}
+// draw cells from the current window and sequence them
+void Sampler::biopsy(Tumour& tumour, RandomNumberGenerator& rng, Biopsy& res) {
+    int remaining = 0;
+    for (int d = 0; d < static_cast<int>(window.size()); d++) {
+        remaining += tumour.getDeme(window[d]).getPopulation();
+    }
+    int toDraw = min(cells, remaining);
+    res.cells = toDraw;
+    int numAlleles = tumour.getDeme(window.front()).getMethCounts().size();
+    methAlleles.assign(numAlleles, 0);
+    // cells per deme (multivariate hypergeometric), then methylated alleles
+    // among them at each locus
+    for (int d = 0; d < static_cast<int>(window.size()) && toDraw > 0; d++) {
+        const Deme& deme = tumour.getDeme(window[d]);
+        int population = deme.getPopulation();
+        int drawn = rng.hypergeometricDist(population, remaining - population, toDraw);
+        remaining -= population;
+        toDraw -= drawn;
+        if (drawn == 0) continue;
+        const std::vector<int>& counts = deme.getMethCounts();
+        for (int a = 0; a < numAlleles; a++) {
+            methAlleles[a] += rng.hypergeometricDist(counts[a], population - counts[a], drawn);
+        }
+    }
+    // sequencing: each read of a site comes from one of its 2 * cells alleles
+    int sites = numAlleles / 2;
+    res.methReads.assign(sites, 0);
+    res.depth.assign(sites, 0);
+    for (int j = 0; j < sites; j++) {
+        int depth = readDepth > 0 ? rng.poissonDist(readDepth) : 0;
+        double beta = res.cells ? (methAlleles[j] + methAlleles[j + sites]) / (2.0 * res.cells) : 0;
+        res.depth[j] = depth;
+        res.methReads[j] = depth ? rng.binomialDist(depth, beta) : 0;
+    }
+}
+
+/////// Streams
+RandomNumberGenerator Sampler::streamFor(const RandomNumberGenerator& runStream) {
+    RandomNumberGenerator stream = runStream;
+    stream.longJump();
+    return stream;
+}
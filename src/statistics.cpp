@@ -0,0 +1,115 @@
+#include "statistics.hpp"
+
+#include <cmath>
+
+/////// Accumulators
+void Welford::add(double x) {
+    n++;
+    double delta = x - mean;
+    mean += delta / n;
+    m2 += delta * (x - mean);
+}
+void Welford::merge(const Welford& other) {
+    if (other.n == 0) return;
+    long total = n + other.n;
+    double delta = other.mean - mean;
+    mean += delta * other.n / total;
+    m2 += other.m2 + delta * delta * n * other.n / total;
+    n = total;
+}
+void Histogram::add(double x) {
+    int bins = counts.size();
+    counts[min(static_cast<int>(x * bins), bins - 1)]++;
+}
+
+// average methylation of site j from per-allele counts
+template<typename T>
+static double averageSite(const std::vector<T>& counts, int j, int sites, int population) {
+    return population ? (counts[j] + counts[j + sites]) / (2.0 * population) : 0;
+}
+
+/////// Constructor
+SummaryStats::SummaryStats(const InputParameters& params)
+    : bins(max(params.stats_bins, 1)), margin(params.stats_margin) {}
+
+/////// Statistics
+// site-beta statistics of one deme or of the tumour
+void SummaryStats::collect(const std::vector<double>& betas, MethStats& res) const {
+    res.beta = Welford();
+    res.betaHist.reset(bins);
+    int fluctuating = 0;
+    for (int j = 0; j < static_cast<int>(betas.size()); j++) {
+        res.beta.add(betas[j]);
+        res.betaHist.add(betas[j]);
+        if (betas[j] > margin && betas[j] < 1 - margin) fluctuating++;
+    }
+    res.fluctuating = betas.empty() ? 0 : static_cast<float>(fluctuating) / betas.size();
+}
+// statistics of every deme and of the whole tumour at the current time
+void SummaryStats::take(Tumour& tumour) {
+    generation = tumour.getGensElapsed();
+    int numDemes = tumour.getNumDemes();
+    demes.resize(numDemes);
+    int sites = numDemes ? tumour.getDeme(0).getNumSites() : 0;
+    this->tumour = MethStats();
+    this->tumour.label = "all";
+    this->tumour.side = "both";
+    tumourCounts.assign(2 * sites, 0);
+    sumStandardised.assign(sites, 0);
+    int standardised = 0; // demes whose site betas vary
+    for (int i = 0; i < numDemes; i++) {
+        const Deme& deme = tumour.getDeme(i);
+        MethStats& res = demes[i];
+        res.label = std::to_string(i);
+        res.side = deme.getSide();
+        res.population = deme.getPopulation();
+        res.numMeth = Welford();
+        res.numDemeth = Welford();
+        const CellStore& cells = deme.getCells();
+        for (int c = 0; c < cells.size(); c++) {
+            res.numMeth.add(cells.getNumMeth(c));
+            res.numDemeth.add(cells.getNumDemeth(c));
+        }
+        this->tumour.population += res.population;
+        this->tumour.numMeth.merge(res.numMeth);
+        this->tumour.numDemeth.merge(res.numDemeth);
+        const std::vector<int>& counts = deme.getMethCounts();
+        siteBeta.resize(sites);
+        for (int j = 0; j < sites; j++) siteBeta[j] = averageSite(counts, j, sites, res.population);
+        for (int a = 0; a < 2 * sites; a++) tumourCounts[a] += counts[a];
+        collect(siteBeta, res);
+        // mean pairwise correlation = (|sum of z|^2 - D) / (D (D - 1)), where
+        // z are the site betas of each deme standardised to unit norm
+        double norm = std::sqrt(res.beta.m2);
+        if (norm > 0) {
+            for (int j = 0; j < sites; j++) sumStandardised[j] += (siteBeta[j] - res.beta.mean) / norm;
+            standardised++;
+        }
+    }
+    // bulk tumour betas
+    siteBeta.resize(sites);
+    for (int j = 0; j < sites; j++) {
+        siteBeta[j] = averageSite(tumourCounts, j, sites, this->tumour.population);
+    }
+    collect(siteBeta, this->tumour);
+    double sumSquares = 0;
+    for (int j = 0; j < sites; j++) sumSquares += sumStandardised[j] * sumStandardised[j];
+    this->tumour.correlation = standardised > 1 ? (sumSquares - standardised) / (standardised * (standardised - 1.0)) : 0;
+    // correlation of each deme with the bulk tumour
+    double tumourNorm = std::sqrt(this->tumour.beta.m2);
+    for (int i = 0; i < numDemes; i++) {
+        MethStats& res = demes[i];
+        double norm = std::sqrt(res.beta.m2);
+        if (norm == 0 || tumourNorm == 0) {
+            res.correlation = 0;
+            continue;
+        }
+        const std::vector<int>& counts = tumour.getDeme(i).getMethCounts();
+        double sum = 0;
+        for (int j = 0; j < sites; j++) {
+            double beta = averageSite(counts, j, sites, res.population);
+            sum += (beta - res.beta.mean) * (siteBeta[j] - this->tumour.beta.mean);
+        }
+        res.correlation = sum / (norm * tumourNorm);
+    }
+}
@@ -0,0 +1,191 @@
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+// collect every leaf of the sweep spec as (config path, list of values)
+static void collectSweepAxes(const boost::property_tree::ptree& tree, const std::string& prefix,
+    std::vector<std::pair<std::string, std::vector<std::string> > >& axes) {
+    for (const auto& child : tree) {
+        std::string path = prefix.empty() ? child.first : prefix + "." + child.first;
+        if (child.second.empty()) {
+            std::istringstream stream(child.second.data());
+            std::vector<std::string> values;
+            std::string value;
+            while (stream >> value) values.push_back(value);
+            axes.push_back(std::make_pair(path, values));
+        } else {
+            collectSweepAxes(child.second, path, axes);
+        }
+    }
+}
+
+// expand the sweep spec into the Cartesian product of its value lists
+std::vector<SweepPoint> expandSweep(const boost::property_tree::ptree& basePt,
+    const boost::property_tree::ptree& sweepPt, const std::string& config_file_path) {
+    std::vector<std::pair<std::string, std::vector<std::string> > > axes;
+    collectSweepAxes(sweepPt, "", axes);
+    int numPoints = 1;
+    for (int a = 0; a < static_cast<int>(axes.size()); a++) {
+        if (!basePt.get_child_optional(axes[a].first) || axes[a].second.empty()) {
+            std::cerr << "ERROR: Sweep parameter " << axes[a].first
+                      << " is not in the config file or has no values." << std::endl;
+            exit(1);
+        }
+        numPoints *= axes[a].second.size();
+    }
+    std::vector<SweepPoint> points;
+    for (int i = 0; i < numPoints; i++) {
+        SweepPoint point;
+        point.index = i;
+        boost::property_tree::ptree pt = basePt;
+        // last axis varies fastest
+        int rest = i;
+        for (int a = axes.size() - 1; a >= 0; a--) {
+            const std::string& value = axes[a].second[rest % axes[a].second.size()];
+            rest /= axes[a].second.size();
+            pt.put(axes[a].first, value);
+            point.values.insert(point.values.begin(), std::make_pair(axes[a].first, value));
+        }
+        point.params = readParameters(pt, config_file_path);
+        point.cost = estimateCost(point.params, deriveParameters(point.params));
+        points.push_back(point);
+    }
+    return points;
+}
+
+// leading point index of a row of sweep_points.csv or sweep_manifest.csv with
+// `fields` fields, or -1 if the row is incomplete (e.g. torn by a crash)
+static int parseSweepRow(const std::string& line, int fields) {
+    if (std::count(line.begin(), line.end(), ',') != fields - 1) return -1;
+    std::string index = line.substr(0, line.find(','));
+    if (index.empty() || index.find_first_not_of("0123456789") != std::string::npos) return -1;
+    return std::stoi(index);
+}
+// row of sweep_points.csv for a point: its index and parameter values
+static std::string sweepPointRow(const SweepPoint& point) {
+    std::string row = std::to_string(point.index);
+    for (int a = 0; a < static_cast<int>(point.values.size()); a++) row += "," + point.values[a].second;
+    return row;
+}
+// header of sweep_points.csv: the config paths of the sweep parameters
+static std::string sweepPointsHeader(const SweepPoint& point) {
+    std::string header = "Point";
+    for (int a = 0; a < static_cast<int>(point.values.size()); a++) header += "," + point.values[a].first;
+    return header;
+}
+
+// rows of the manifest of points already recorded as finished, by point index;
+// rows that do not parse are ignored
+std::map<int, std::string> readSweepManifest(const std::string& manifest_path) {
+    std::map<int, std::string> done;
+    std::ifstream manifest(manifest_path);
+    std::string line;
+    std::getline(manifest, line); // header
+    while (std::getline(manifest, line)) {
+        int index = parseSweepRow(line, 7);
+        if (index >= 0) done[index] = line;
+    }
+    return done;
+}
+// indices of the points whose parameter values in the sweep_points.csv of a
+// previous invocation match the current expansion
+std::set<int> readUnchangedPoints(const std::string& points_path, const std::vector<SweepPoint>& points) {
+    std::set<int> unchanged;
+    std::ifstream pointsFile(points_path);
+    std::string line;
+    if (!std::getline(pointsFile, line) || line != sweepPointsHeader(points[0])) return unchanged;
+    std::map<int, std::string> rows;
+    while (std::getline(pointsFile, line)) {
+        int index = parseSweepRow(line, points[0].values.size() + 1);
+        if (index >= 0) rows[index] = line;
+    }
+    for (int i = 0; i < static_cast<int>(points.size()); i++) {
+        auto row = rows.find(points[i].index);
+        if (row != rows.end() && row->second == sweepPointRow(points[i])) unchanged.insert(points[i].index);
+    }
+    return unchanged;
+}
+
+// events scale with the number of cells times the generations they are followed for
+double estimateCost(const InputParameters& params, const DerivedParameters& d_params) {
+    return static_cast<double>(params.deme_carrying_capacity) * d_params.max_demes
+        * params.max_fissions * (1 + params.turnover);
+}
+
+// run every point of the sweep, most expensive first, skipping points that a
+// previous (possibly killed) invocation already finished with the same values
+void runSweep(const std::string& input_and_output_path,
+    const boost::property_tree::ptree& basePt, const std::string& sweep_file_with_path,
+    int numThreads, bool resume) {
+    boost::property_tree::ptree sweepPt;
+    boost::property_tree::info_parser::read_info(sweep_file_with_path, sweepPt);
+    std::vector<SweepPoint> points = expandSweep(basePt, sweepPt, sweep_file_with_path);
+
+    // results of a previous invocation are kept only for points whose values
+    // have not changed since, if the sweep spec was edited in between
+    std::string points_path = input_and_output_path + "sweep_points.csv";
+    std::set<int> unchanged = readUnchangedPoints(points_path, points);
+    std::string manifest_path = input_and_output_path + "sweep_manifest.csv";
+    std::map<int, std::string> finished = readSweepManifest(manifest_path);
+    std::set<int> done;
+    {
+        // rewrite the manifest without rows of changed points or torn rows
+        FileOutput manifest(manifest_path);
+        manifest.writeSummaryHeader();
+    }
+    {
+        std::ofstream manifest(manifest_path, std::ofstream::app);
+        for (const auto& row : finished) {
+            if (!unchanged.count(row.first)) continue;
+            manifest << row.second << std::endl;
+            done.insert(row.first);
+        }
+    }
+    FileOutput manifest(manifest_path, true);
+
+    // map of point directories to parameter values
+    std::ofstream pointsFile(points_path);
+    pointsFile << sweepPointsHeader(points[0]) << std::endl;
+    for (int i = 0; i < static_cast<int>(points.size()); i++) {
+        pointsFile << sweepPointRow(points[i]) << std::endl;
+    }
+    pointsFile.close();
+
+    std::vector<SweepPoint> todo;
+    for (int i = 0; i < static_cast<int>(points.size()); i++) {
+        if (!done.count(points[i].index)) todo.push_back(points[i]);
+    }
+    std::stable_sort(todo.begin(), todo.end(), [](const SweepPoint& a, const SweepPoint& b) {
+        return a.cost > b.cost;
+    });
+
+    std::vector<BatchJob> jobs;
+    for (int k = 0; k < static_cast<int>(todo.size()); k++) {
+        jobs.push_back({ "point_" + std::to_string(todo[k].index), [&, k](const std::string& pointPath) -> SimSummary {
+            const SweepPoint& point = todo[k];
+            InputParameters pointParams = jobParameters(point.params);
+            // checkpoints of a point whose values changed belong to other values
+            bool resumePoint = resume && unchanged.count(point.index);
+            return runSim(pointPath, pointParams, deriveParameters(pointParams),
+                RandomNumberGenerator(pointParams.seed), false, resumePoint);
+        } });
+    }
+    std::cout << "Sweep of " << points.size() << " points: " << done.size()
+              << " already finished, " << todo.size() << " to run on "
+              << ThreadPool::resolveNumThreads(numThreads) << " threads." << std::endl;
+    std::vector<SimSummary> summaries;
+    bool completed = runBatch(input_and_output_path, jobs, numThreads, summaries,
+        [&](int k, const SimSummary& summary) {
+            // a point is recorded only once its outputs are complete
+            manifest.writeSummaryRow(std::to_string(todo[k].index), summary);
+            std::cout << "Point " << todo[k].index << " finished: "
+                      << summary.runningTime << " seconds." << std::endl;
+        });
+    if (!completed) {
+        std::cout << "Stopped: rerun to continue (with --resume to continue interrupted points from their checkpoints)." << std::endl;
+        return;
+    }
+    std::cout << "End of sweep." << std::endl;
+}
@@ -0,0 +1,87 @@
+#include "threadpool.hpp"
+
+/////// Constructor and destructor
+ThreadPool::ThreadPool(int numThreads) {
+    numThreads = resolveNumThreads(numThreads);
+    for (int i = 0; i < numThreads; i++) {
+        queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+    }
+    for (int i = 0; i < numThreads; i++) {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
+        workers[i].join();
+    }
+}
+
+/////// Task handling
+// queue a task; tasks submitted first are started first by their worker
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending++;
+        queued++;
+        TaskQueue& queue = *queues[nextQueue];
+        nextQueue = (nextQueue + 1) % queues.size();
+        std::lock_guard<std::mutex> queueLock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    taskAvailable.notify_one();
+}
+// block until every submitted task has finished
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [this] { return pending == 0; });
+}
+// take from the front of the worker's own queue, else steal from the back of another
+bool ThreadPool::takeTask(int self, std::function<void()>& task) {
+    int n = queues.size();
+    for (int k = 0; k < n; k++) {
+        TaskQueue& queue = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> queueLock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        if (k == 0) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+// worker thread body
+void ThreadPool::workerLoop(int self) {
+    while (true) {
+        std::function<void()> task;
+        if (takeTask(self, task)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queued--;
+            }
+            task();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) allDone.notify_all();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        taskAvailable.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
+
+/////// Getters
+// number of threads to use: requested > 0, else all hardware threads
+int ThreadPool::resolveNumThreads(int requested) {
+    if (requested > 0) return requested;
+    int hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
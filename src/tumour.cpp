@@ -1,21 +1,30 @@
 #include "tumour.hpp"
 
+#include <type_traits>
+
+// demes relocate by moving their cell buffers, never by copying cells
+static_assert(std::is_nothrow_move_constructible<Deme>::value,
+              "Deme must be nothrow move constructible");
+
 /////// Constructor
 Tumour::Tumour(const InputParameters &params,
-               const DerivedParameters &d_params) {
+               const DerivedParameters &d_params,
+               const RandomNumberGenerator &stream)
+    : rng(stream) {
   demes.clear();
-  genotypes.clear();
+  demes.reserve(d_params.max_demes);
   // driver genotypes:
-  std::shared_ptr<Genotype> firstGenotype = std::make_shared<Genotype>(
-      0, 0, 0, 0, 1, params.init_migration_rate, 0, params);
-  genotypes.push_back(firstGenotype);
+  genotypes = GenotypeRegistry(DriverParameters(params));
+  int firstGenotype = genotypes.add(
+      Genotype(0, 0, 0, 0, 1, params.init_migration_rate, 0));
 
   // demes:
   Deme firstDeme(params.deme_carrying_capacity, "left", 0, 1, 0,
                  params.baseline_death_rate, params.baseline_death_rate, 1,
-                 params.init_migration_rate);
-  demes.push_back(firstDeme);
-  demes.back().initialise(firstGenotype, params, d_params);
+                 params.init_migration_rate, rng.split());
+  demes.push_back(std::move(firstDeme));
+  demes.back().initialise(firstGenotype, genotypes, params, d_params);
+  updateAllDemes();
 
   // max gillespie generations to run
   maxGens = params.max_generations;
@@ -24,40 +33,87 @@ Tumour::Tumour(const InputParameters &params,
   fissionConfig = params.fission_config;
 }
 
-/////// Choose events based on rate sums
-// choose deme
-int Tumour::chooseDeme() {
-  std::vector<double> cumRates(demes.size());
-  double r;
-  int res = 0;
-
-  if (cumRates.size() == 1) {
-    return res;
+/////// Cached aggregates
+// refresh the rate, population, fissions and genotypes of one deme, appending
+// it if new
+void Tumour::updateDeme(int index) {
+  Deme &deme = demes[index];
+  collectGenotypeChanges(deme);
+  if (index == demeRates.size()) {
+    demeRates.pushBack(deme.getSumOfRates());
+    demePopulations.push_back(0);
+    demeFissions.push_back(0);
   } else {
-    double sumOfRates = demes[0].getSumOfRates();
-    cumRates[0] = sumOfRates;
-    for (int i = 1; i < cumRates.size(); i++) {
-      sumOfRates = demes[i].getSumOfRates();
-      cumRates[i] += sumOfRates + cumRates[i - 1];
+    demeRates.set(index, deme.getSumOfRates());
+  }
+  numCells += deme.getPopulation() - demePopulations[index];
+  numFissions += deme.getFissions() - demeFissions[index];
+  demePopulations[index] = deme.getPopulation();
+  demeFissions[index] = deme.getFissions();
+  // bound floating-point drift in the partial sums
+  if (RATE_RESUM_INTERVAL > 0 && ++eventsSinceRebuild >= RATE_RESUM_INTERVAL) {
+    demeRates.rebuild();
+    eventsSinceRebuild = 0;
+  }
+}
+// recompute every aggregate from the demes
+void Tumour::updateAllDemes() {
+  demeRates.clear();
+  demePopulations.clear();
+  demeFissions.clear();
+  numCells = 0;
+  numFissions = 0;
+  for (int i = 0; i < static_cast<int>(demes.size()); i++) {
+    updateDeme(i);
+  }
+  applyGenotypeChanges();
+  eventsSinceRebuild = 0;
+}
+// move the genotypes a deme created into the table, in creation order so
+// that parents are stored before children, and collect its clone changes
+void Tumour::collectGenotypeChanges(Deme &deme) {
+  const std::vector<Genotype> &newGenotypes = deme.getNewGenotypes();
+  if (!newGenotypes.empty()) {
+    std::vector<int> newIndices(newGenotypes.size());
+    for (int k = 0; k < static_cast<int>(newGenotypes.size()); k++) {
+      Genotype genotype = newGenotypes[k];
+      if (genotype.getParentIndex() < 0)
+        genotype.setParentIndex(newIndices[~genotype.getParentIndex()]);
+      newIndices[k] = genotypes.add(genotype);
     }
-    double rnd = RandomNumberGenerator::getInstance().unitUnifDist();
-    r = rnd * cumRates.back();
+    deme.commitGenotypes(newIndices);
   }
-  if (cumRates.size() == 2) {
-    res = r < cumRates[0] ? 0 : 1;
-    return res;
-  } else {
-    res = std::lower_bound(cumRates.begin(), cumRates.end(), r) -
-          cumRates.begin();
-    return res;
+  deme.drainCloneChanges(foundedClones, extinctClones);
+}
+// apply the collected clone changes; new clones are counted first, so a clone
+// that moved between demes keeps its genotype alive
+void Tumour::applyGenotypeChanges() {
+  for (int i = 0; i < static_cast<int>(foundedClones.size()); i++) {
+    genotypes.retain(foundedClones[i]);
+  }
+  for (int i = 0; i < static_cast<int>(extinctClones.size()); i++) {
+    genotypes.release(extinctClones[i]);
   }
+  foundedClones.clear();
+  extinctClones.clear();
+}
+
+/////// Choose events based on rate sums
+// choose deme in O(log D) from the deme rate tree
+int Tumour::chooseDeme() {
+  if (demes.size() == 1)
+    return 0;
+  double rnd = rng.unitUnifDist();
+  return demeRates.find(rnd * demeRates.total());
 }
 // choose event type
-std::string Tumour::chooseEventType(int chosenDeme, int chosenCell) {
+template <>
+EventType Tumour::chooseEventType<SelectiveRates>(int chosenDeme, int chosenCell,
+                                                  RandomNumberGenerator &stream) {
   std::vector<float> cumRates;
   int ctr = 0;
   float res;
-  double rnd = RandomNumberGenerator::getInstance().unitUnifDist();
+  double rnd = stream.unitUnifDist();
   // cell birth rate
   cumRates.push_back(demes[chosenDeme].getCellBirth(chosenCell));
   ctr++;
@@ -72,37 +128,51 @@ std::string Tumour::chooseEventType(int chosenDeme, int chosenCell) {
   // weighted choice
   res = rnd * cumRates.back();
   if (res < cumRates[0]) {
-    return "birth";
+    return EventType::Birth;
   } else if (res < cumRates[1]) {
-    return "death";
+    return EventType::Death;
   } else {
-    return "fission";
+    return EventType::Fission;
   }
 }
+// choose event type when every cell of the deme shares its rates
+template <>
+EventType Tumour::chooseEventType<NeutralRates>(int chosenDeme, int chosenCell,
+                                                RandomNumberGenerator &stream) {
+  const Deme &deme = demes[chosenDeme];
+  double rnd = stream.unitUnifDist();
+  float birth = deme.getCellBirth(chosenCell);
+  float death = birth + deme.getDeathRate();
+  float res = rnd * (turnoverIndicator ? death : death + deme.getCellMig(chosenCell));
+  return res < birth ? EventType::Birth
+                     : (res < death ? EventType::Death : EventType::Fission);
+}
 
 // perform event
+template <typename Rates>
 void Tumour::event(const InputParameters &params,
                    const DerivedParameters &d_params) {
   int chosenDeme = chooseDeme();
-  int chosenCell = demes[chosenDeme].chooseCell();
-  std::string eventType = chooseEventType(chosenDeme, chosenCell);
+  int chosenCell = demes[chosenDeme].chooseCell<Rates>();
+  EventType eventType = chooseEventType<Rates>(chosenDeme, chosenCell,
+                                               demes[chosenDeme].getStream());
 
-  if (eventType == "birth") {
+  if (eventType == EventType::Birth) {
     demes[chosenDeme].cellDivision(chosenCell, &nextCellID, &nextGenotypeID,
-                                   gensElapsed, params);
-  } else if (eventType == "death") {
+                                   gensElapsed, genotypes);
+  } else if (eventType == EventType::Death) {
     demes[chosenDeme].cellDeath(chosenCell);
-  } else if (eventType == "fission" && demes[chosenDeme].getPopulation() >=
+  } else if (eventType == EventType::Fission && demes[chosenDeme].getPopulation() >=
                                            params.deme_carrying_capacity) {
     float fission_weight = 1.0 / d_params.fission_modifier;
-    float rnd = RandomNumberGenerator::getInstance().unitUnifDist();
+    float rnd = rng.unitUnifDist();
     if (params.right_demes == -1 || params.left_demes == -1) {
       if (rnd <= fission_weight && demes.size() < d_params.max_demes) {
         if (demes.size() == 1) {
-          demes.push_back(demes[chosenDeme].demeFission(gensElapsed, true));
+          demes.push_back(demes[chosenDeme].demeFission(demes.size(), gensElapsed, rng.split(), true));
           rightDemes = 1;
         } else {
-          demes.push_back(demes[chosenDeme].demeFission(gensElapsed));
+          demes.push_back(demes[chosenDeme].demeFission(demes.size(), gensElapsed, rng.split()));
         }
       } else {
         demes[chosenDeme].pseudoFission();
@@ -116,10 +186,10 @@ void Tumour::event(const InputParameters &params,
       if (sideIndicator && rnd <= fission_weight &&
           demes.size() < d_params.max_demes) {
         if (demes.size() == 1) {
-          demes.push_back(demes[chosenDeme].demeFission(gensElapsed, true));
+          demes.push_back(demes[chosenDeme].demeFission(demes.size(), gensElapsed, rng.split(), true));
           rightDemes = 1;
         } else {
-          demes.push_back(demes[chosenDeme].demeFission(gensElapsed));
+          demes.push_back(demes[chosenDeme].demeFission(demes.size(), gensElapsed, rng.split()));
           if (rightIndicator) {
             rightDemes++;
           } else if (leftIndicator) {
@@ -131,32 +201,199 @@ void Tumour::event(const InputParameters &params,
       }
     }
   }
+  updateDeme(chosenDeme);
+  if (demeRates.size() < static_cast<int>(demes.size()))
+    updateDeme(demes.size() - 1);
+  applyGenotypeChanges();
 }
+template void Tumour::event<SelectiveRates>(const InputParameters &params,
+                                            const DerivedParameters &d_params);
+template void Tumour::event<NeutralRates>(const InputParameters &params,
+                                          const DerivedParameters &d_params);
 
-/////// Sum all rates
-float Tumour::sumAllRates() {
-  float res = 0;
-  for (int i = 0; i < demes.size(); i++) {
-    res += demes[i].getSumOfRates();
+/////// Independent demes
+// Once demes can no longer fission into new demes (turnover phase), their
+// events do not interact, so each deme can run its own Gillespie clock.
+// advance one deme until its next event would fall past `horizon`
+template <typename Rates>
+long Tumour::advanceDeme(int index, double &clock, double horizon,
+                         int *demeCellID, int *demeGenotypeID, int idStride,
+                         const InputParameters &params) {
+  Deme &deme = demes[index];
+  RandomNumberGenerator &stream = deme.getStream();
+  long events = 0;
+  while (true) {
+    double rate = deme.getSumOfRates();
+    if (rate <= 0)
+      break;
+    double dt = stream.expDist(rate);
+    if (clock + dt >= horizon)
+      break;
+    clock += dt;
+    int chosenCell = deme.chooseCell<Rates>();
+    EventType eventType = chooseEventType<Rates>(index, chosenCell, stream);
+    if (eventType == EventType::Birth) {
+      // the genotype table is only read while demes advance concurrently
+      deme.cellDivision(chosenCell, demeCellID, demeGenotypeID, clock,
+                        genotypes, idStride);
+    } else if (eventType == EventType::Death) {
+      deme.cellDeath(chosenCell);
+    } else if (eventType == EventType::Fission &&
+               deme.getPopulation() >= params.deme_carrying_capacity) {
+      deme.pseudoFission();
+    }
+    events++;
+  }
+  // the pending event is discarded: by memorylessness the next epoch
+  // restarts exactly from the horizon
+  clock = horizon;
+  return events;
+}
+// advance all demes to `horizon` on the pool, largest demes first
+template <typename Rates>
+long Tumour::advanceDemes(float horizon, ThreadPool &pool,
+                          const InputParameters &params) {
+  int numDemes = demes.size();
+  // cell and genotype IDs are handed out with stride numDemes so that
+  // concurrent demes never collide
+  std::vector<int> cellIDs(numDemes), genotypeIDs(numDemes);
+  std::vector<long> events(numDemes, 0);
+  std::vector<int> order(numDemes);
+  for (int i = 0; i < numDemes; i++) {
+    order[i] = i;
+    cellIDs[i] = nextCellID + i;
+    genotypeIDs[i] = nextGenotypeID + i;
   }
+  std::sort(order.begin(), order.end(), [this](int a, int b) {
+    return demes[a].getPopulation() > demes[b].getPopulation();
+  });
+  for (int k = 0; k < numDemes; k++) {
+    int i = order[k];
+    pool.submit([this, i, horizon, numDemes, &params, &cellIDs, &genotypeIDs,
+                 &events] {
+      double clock = gensElapsed;
+      events[i] = advanceDeme<Rates>(i, clock, horizon, &cellIDs[i], &genotypeIDs[i],
+                              numDemes, params);
+    });
+  }
+  pool.wait();
+  // merge
+  long res = 0;
+  for (int i = 0; i < numDemes; i++) {
+    nextCellID = max(nextCellID, cellIDs[i]);
+    nextGenotypeID = max(nextGenotypeID, genotypeIDs[i]);
+    res += events[i];
+  }
+  gensElapsed = horizon;
+  updateAllDemes();
   return res;
 }
+template long Tumour::advanceDemes<SelectiveRates>(float horizon,
+                                                   ThreadPool &pool,
+                                                   const InputParameters &params);
+template long Tumour::advanceDemes<NeutralRates>(float horizon,
+                                                 ThreadPool &pool,
+                                                 const InputParameters &params);
+
+/////// Checkpointing
+// write the complete tumour state; genotypes are written once and referred
+// to by registry index from cells
+void Tumour::save(CheckpointWriter &out) const {
+  genotypes.save(out);
+  for (int i = 0; i < 4; i++)
+    out.write<uint64_t>(rng.getState(i));
+  out.write<int32_t>(nextGenotypeID);
+  out.write<int32_t>(nextCellID);
+  out.write<int32_t>(leftDemes);
+  out.write<int32_t>(rightDemes);
+  out.write<double>(gensElapsed);
+  out.write<float>(outputTimer);
+  out.write<int32_t>(maxGens);
+  out.write<int32_t>(fissionConfig);
+  out.write<int32_t>(turnoverIndicator);
+  out.write<uint64_t>(demes.size());
+  for (int i = 0; i < static_cast<int>(demes.size()); i++) {
+    demes[i].save(out);
+  }
+  demeRates.save(out);
+  out.write<int32_t>(eventsSinceRebuild);
+}
+// replace the tumour state with one written by save()
+void Tumour::load(CheckpointReader &in, const InputParameters &params,
+                  const DerivedParameters &d_params) {
+  genotypes.load(in);
+  for (int i = 0; i < 4; i++)
+    rng.setState(i, in.read<uint64_t>());
+  nextGenotypeID = in.read<int32_t>();
+  nextCellID = in.read<int32_t>();
+  leftDemes = in.read<int32_t>();
+  rightDemes = in.read<int32_t>();
+  gensElapsed = in.read<double>();
+  outputTimer = in.read<float>();
+  maxGens = in.read<int32_t>();
+  fissionConfig = in.read<int32_t>();
+  turnoverIndicator = in.read<int32_t>();
+  uint64_t numDemes = in.read<uint64_t>();
+  demes.clear();
+  // room for every deme the rest of the run can create, so demes never relocate
+  demes.reserve(max(static_cast<int>(numDemes), d_params.max_demes));
+  for (uint64_t i = 0; i < numDemes; i++) {
+    demes.push_back(Deme::restore(in, genotypes, params));
+  }
+  // totals are exact; the rate tree is restored with its rounding
+  updateAllDemes();
+  demeRates.load(in);
+  eventsSinceRebuild = in.read<int32_t>();
+}
+
+/////// Sum all rates
+float Tumour::sumAllRates() { return demeRates.total(); }
 
 /////// Getters
-// get total number of cells tracked in tumour
-int Tumour::getNumCells() const {
+// largest rate-sum drift corrected by re-summation in any deme
+double Tumour::getMaxRateDrift() const {
+  double res = 0;
+  for (int i = 0; i < static_cast<int>(demes.size()); i++) {
+    res = max(res, demes[i].getMaxRateDrift());
+  }
+  return res;
+}
+// total number of exact rate re-summations across demes
+int Tumour::getRateResums() const {
+  int res = 0;
+  for (int i = 0; i < static_cast<int>(demes.size()); i++) {
+    res += demes[i].getRateResums();
+  }
+  return res;
+}
+// number of (deme, driver genotype) clones
+int Tumour::getNumClones() const {
   int res = 0;
-  for (int i = 0; i < demes.size(); i++) {
-    res += demes[i].getPopulation();
+  for (int i = 0; i < static_cast<int>(demes.size()); i++) {
+    res += demes[i].getNumClones();
   }
   return res;
 }
-// get average number of fissions per deme
-float Tumour::getFissionsPerDeme() {
-  float res = 0;
-  for (int i = 0; i < demes.size(); i++) {
-    res += demes[i].getFissions();
+// methylation row allocation counters summed over demes
+SlabStats Tumour::getSlabStats() const {
+  SlabStats res;
+  for (int i = 0; i < static_cast<int>(demes.size()); i++) {
+    res.add(demes[i].getSlabStats());
   }
-  res /= demes.size();
   return res;
 }
+
+/////// Forking
+// replace the tumour stream and split fresh deme streams from it, in deme order
+void Tumour::reseed(const RandomNumberGenerator &stream) {
+  rng = stream;
+  for (int i = 0; i < static_cast<int>(demes.size()); i++) {
+    demes[i].setStream(rng.split());
+  }
+}
+// change the methylation rates of every cell in the tumour
+void Tumour::setMethylationRates(float methRate, float demethRate) {
+  for (int i = 0; i < static_cast<int>(demes.size()); i++) {
+    demes[i].setMethylationRates(methRate, demethRate);
+  }
+}
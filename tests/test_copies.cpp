@@ -0,0 +1,84 @@
+// Allocation and copy counters of methylation rows: divisions copy one row,
+// fissions copy one row per moved cell, slabs do not reallocate while the
+// population overshoots K within the reserved headroom, and demes relocate
+// without copying their cells.
+// Run from the repository root: make test
+
+#include "initialise.hpp"
+#include "input.hpp"
+#include "tumour.hpp"
+
+#include <boost/property_tree/info_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <iostream>
+#include <utility>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    std::cout << (condition ? "ok:   " : "FAIL: ") << what << std::endl;
+    if (!condition) failures++;
+}
+
+int main() {
+    boost::property_tree::ptree pt;
+    boost::property_tree::info_parser::read_info("resources/config.dat", pt);
+    // no driver mutations, so every division only copies the parent's row
+    pt.put("mutation.mu_driver_birth", 0);
+    pt.put("mutation.mu_driver_migration", 0);
+    InputParameters params = readParameters(pt, "resources/config.dat");
+    DerivedParameters d_params = deriveParameters(params);
+    int K = params.deme_carrying_capacity;
+
+    Tumour tumour(params, d_params, RandomNumberGenerator(params.seed));
+    Deme& deme = tumour.getDeme(0);
+    SlabStats before = deme.getSlabStats();
+    int nextCellID = tumour.getNextCellID();
+    int nextGenotypeID = tumour.getNextGenotypeID();
+
+    // divisions past the carrying capacity, up to the reserved headroom
+    int capacity = Deme::cellCapacity(K);
+    int divisions = 0;
+    while (deme.getPopulation() < capacity) {
+        deme.cellDivision(divisions % deme.getPopulation(), &nextCellID, &nextGenotypeID,
+            0, tumour.getGenotypes());
+        divisions++;
+    }
+    SlabStats grown = deme.getSlabStats();
+    check(capacity > K, "population pushed past K");
+    check(grown.copiedRows - before.copiedRows == divisions, "one row copy per division");
+    check(grown.grows == before.grows, "no slab grows up to the reserved headroom");
+
+    // beyond the headroom the slab grows once, by a fixed step
+    deme.cellDivision(0, &nextCellID, &nextGenotypeID, 0, tumour.getGenotypes());
+    divisions++;
+    SlabStats overflow = deme.getSlabStats();
+    check(overflow.grows == before.grows + 1 &&
+        overflow.rowCapacity == capacity + Deme::cellGrowStep(K), "slab grows by a fixed step when full");
+
+    // fission: moved cells are copied once into the new deme's slab
+    Deme newDeme = deme.demeFission(1, 0, RandomNumberGenerator(1), true);
+    int moved = newDeme.getPopulation();
+    SlabStats split = deme.getSlabStats();
+    split.add(newDeme.getSlabStats());
+    check(moved > 0 && deme.getPopulation() > 0, "fission moves part of the deme");
+    check(split.copiedRows - before.copiedRows == divisions + moved, "copiedRows == divisions + moved cells");
+    check(newDeme.getSlabStats().grows == 1 && deme.getSlabStats().grows == overflow.grows,
+        "no slab grows in either deme during fission");
+
+    // relocating demes moves their cell buffers
+    std::vector<Deme> demes;
+    demes.reserve(1);
+    demes.push_back(std::move(newDeme));
+    const uint64_t* row = demes[0].getCells().getRow(0);
+    long copied = demes[0].getSlabStats().copiedRows;
+    demes.push_back(deme.demeFission(2, 0, RandomNumberGenerator(2)));
+    check(demes.capacity() > 1, "demes storage reallocated");
+    check(demes[0].getCells().getRow(0) == row, "no CellStore copies when demes grows");
+    check(demes[0].getSlabStats().copiedRows == copied, "no rows copied when demes grows");
+
+    std::cout << (failures ? "FAILED" : "PASSED") << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+// Random number stream layout: no replicate's biopsy stream coincides with
+// any replicate's tumour or deme streams, or with another biopsy stream (see
+// the block layout in distributions.hpp).
+// Run from the repository root: make test
+
+#include "ensemble.hpp"
+#include "initialise.hpp"
+#include "input.hpp"
+#include "sampling.hpp"
+#include "tumour.hpp"
+
+#include <boost/property_tree/info_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <iostream>
+#include <set>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    std::cout << (condition ? "ok:   " : "FAIL: ") << what << std::endl;
+    if (!condition) failures++;
+}
+
+static bool sameState(const RandomNumberGenerator& a, const RandomNumberGenerator& b) {
+    for (int i = 0; i < 4; i++) {
+        if (a.getState(i) != b.getState(i)) return false;
+    }
+    return true;
+}
+
+int main() {
+    boost::property_tree::ptree pt;
+    boost::property_tree::info_parser::read_info("resources/config.dat", pt);
+    InputParameters params = readParameters(pt, "resources/config.dat");
+    DerivedParameters d_params = deriveParameters(params);
+    const int replicates = 4;
+    // splits per run checked: far more than the demes of any run here
+    const int splits = 4 * d_params.max_demes + 64;
+
+    std::vector<RandomNumberGenerator> streams = replicateStreams(params.seed, replicates);
+    // tumour and deme streams of every replicate (J^k of its stream) and
+    // their first draws
+    std::vector<RandomNumberGenerator> simStreams;
+    std::set<uint64_t> simDraws;
+    for (int r = 0; r < replicates; r++) {
+        RandomNumberGenerator stream = streams[r];
+        for (int k = 0; k < splits; k++) {
+            simStreams.push_back(stream);
+            RandomNumberGenerator draws = stream;
+            for (int n = 0; n < 16; n++) simDraws.insert(draws());
+            stream.jump();
+        }
+    }
+    // biopsy streams as runSim derives them
+    std::vector<RandomNumberGenerator> biopsyStreams;
+    for (int r = 0; r < replicates; r++) {
+        Tumour tumour(params, d_params, streams[r]);
+        biopsyStreams.push_back(Sampler::streamFor(tumour.getStream()));
+    }
+
+    bool disjoint = true;
+    bool freshDraws = true;
+    for (int b = 0; b < replicates; b++) {
+        for (int s = 0; s < static_cast<int>(simStreams.size()); s++) {
+            if (sameState(biopsyStreams[b], simStreams[s])) disjoint = false;
+        }
+        for (int c = 0; c < b; c++) {
+            if (sameState(biopsyStreams[b], biopsyStreams[c])) disjoint = false;
+        }
+        RandomNumberGenerator draws = biopsyStreams[b];
+        for (int n = 0; n < 16; n++) {
+            if (simDraws.count(draws())) freshDraws = false;
+        }
+    }
+    check(disjoint, "no biopsy stream starts at a tumour, deme or other biopsy stream");
+    check(freshDraws, "no biopsy draw repeats a draw of a tumour or deme stream");
+
+    std::cout << (failures ? "FAILED" : "PASSED") << std::endl;
+    return failures ? 1 : 0;
+}